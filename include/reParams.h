@@ -14,6 +14,12 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <time.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <limits>
+#include <type_traits>
 #include "sys/queue.h"
 #include "project_config.h"
 #include "def_consts.h"
@@ -32,6 +38,175 @@
 #include "reTgSend.h"
 #endif // CONFIG_TELEGRAM_ENABLE
 
+// Number of buckets in the parameter hash indexes
+#ifndef CONFIG_PARAMS_INDEX_SIZE
+#define CONFIG_PARAMS_INDEX_SIZE 64
+#endif // CONFIG_PARAMS_INDEX_SIZE
+
+// Delayed (write-behind) saving of changed parameters to NVS: all changes accumulated 
+// during CONFIG_PARAMS_NVS_WRITE_DELAY milliseconds are written with one commit per group
+#ifndef CONFIG_PARAMS_NVS_DELAYED_WRITE
+#define CONFIG_PARAMS_NVS_DELAYED_WRITE 0
+#endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+#ifndef CONFIG_PARAMS_NVS_WRITE_DELAY
+#define CONFIG_PARAMS_NVS_WRITE_DELAY 3000
+#endif // CONFIG_PARAMS_NVS_WRITE_DELAY
+
+// Deferred restoring of values from NVS: registration does not read NVS, all values 
+// are read by paramsRestoreAll() opening each group namespace only once
+#ifndef CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+#define CONFIG_PARAMS_NVS_DEFERRED_RESTORE 0
+#endif // CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+// Task for background work (delayed saving to NVS, etc.): timers only wake it up, so that flash operations 
+// and network I/O are not performed in the timer service task
+#ifndef CONFIG_PARAMS_WORKER_TASK_STACK_SIZE
+#define CONFIG_PARAMS_WORKER_TASK_STACK_SIZE 4096
+#endif // CONFIG_PARAMS_WORKER_TASK_STACK_SIZE
+#ifndef CONFIG_PARAMS_WORKER_TASK_PRIORITY
+#define CONFIG_PARAMS_WORKER_TASK_PRIORITY 3
+#endif // CONFIG_PARAMS_WORKER_TASK_PRIORITY
+#ifndef CONFIG_PARAMS_WORKER_TASK_CORE
+#define CONFIG_PARAMS_WORKER_TASK_CORE tskNO_AFFINITY
+#endif // CONFIG_PARAMS_WORKER_TASK_CORE
+// Buffer on the stack for reading string values from NVS, longer strings are read by reNvs
+#ifndef CONFIG_PARAMS_NVS_STRING_BUFFER
+#define CONFIG_PARAMS_NVS_STRING_BUFFER 64
+#endif // CONFIG_PARAMS_NVS_STRING_BUFFER
+
+// Asynchronous calling of change handlers: notifications are queued and handlers 
+// are called by a separate task outside of the parameter lock
+#ifndef CONFIG_PARAMS_HANDLER_ASYNC
+#define CONFIG_PARAMS_HANDLER_ASYNC 0
+#endif // CONFIG_PARAMS_HANDLER_ASYNC
+#ifndef CONFIG_PARAMS_HANDLER_QUEUE_SIZE
+#define CONFIG_PARAMS_HANDLER_QUEUE_SIZE 32
+#endif // CONFIG_PARAMS_HANDLER_QUEUE_SIZE
+#ifndef CONFIG_PARAMS_HANDLER_TASK_STACK_SIZE
+#define CONFIG_PARAMS_HANDLER_TASK_STACK_SIZE 4096
+#endif // CONFIG_PARAMS_HANDLER_TASK_STACK_SIZE
+#ifndef CONFIG_PARAMS_HANDLER_TASK_PRIORITY
+#define CONFIG_PARAMS_HANDLER_TASK_PRIORITY 5
+#endif // CONFIG_PARAMS_HANDLER_TASK_PRIORITY
+#ifndef CONFIG_PARAMS_HANDLER_TASK_CORE
+#define CONFIG_PARAMS_HANDLER_TASK_CORE tskNO_AFFINITY
+#endif // CONFIG_PARAMS_HANDLER_TASK_CORE
+
+// Size of the memory blocks in which the MQTT topics of the parameters are stored
+#ifndef CONFIG_PARAMS_TOPIC_ARENA_BLOCK
+#define CONFIG_PARAMS_TOPIC_ARENA_BLOCK 512
+#endif // CONFIG_PARAMS_TOPIC_ARENA_BLOCK
+
+// Number of parameters (groups) in one block of memory allocated for the registry
+#ifndef CONFIG_PARAMS_SLAB_ITEMS
+#define CONFIG_PARAMS_SLAB_ITEMS 16
+#endif // CONFIG_PARAMS_SLAB_ITEMS
+
+// Size of the stack buffer used to format numeric values for publishing and notifications
+#ifndef CONFIG_PARAMS_FORMAT_BUFFER_SIZE
+#define CONFIG_PARAMS_FORMAT_BUFFER_SIZE 32
+#endif // CONFIG_PARAMS_FORMAT_BUFFER_SIZE
+
+// Rate limited publishing of values: a change only marks the parameter as pending, pending parameters are published 
+// with their current values by a timer every CONFIG_PARAMS_MQTT_PUBLISH_INTERVAL ms, but no more than 
+// CONFIG_PARAMS_MQTT_PUBLISH_LIMIT per period and only while the outbox is below CONFIG_PARAMS_MQTT_OUTBOX_HIGH. 
+// Intermediate values of frequently changed parameters are not sent
+#ifndef CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+#define CONFIG_PARAMS_MQTT_PUBLISH_QUEUE 0
+#endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+#ifndef CONFIG_PARAMS_MQTT_PUBLISH_INTERVAL
+#define CONFIG_PARAMS_MQTT_PUBLISH_INTERVAL 200
+#endif // CONFIG_PARAMS_MQTT_PUBLISH_INTERVAL
+#ifndef CONFIG_PARAMS_MQTT_PUBLISH_LIMIT
+#define CONFIG_PARAMS_MQTT_PUBLISH_LIMIT 16
+#endif // CONFIG_PARAMS_MQTT_PUBLISH_LIMIT
+
+// Bulk change of parameters: each group has the topic "%CONFIG% / group / CONFIG_PARAMS_MQTT_BULK_KEY", which accepts 
+// a JSON object {"key": value, ...}. All values are applied under one lock of the group with one NVS commit, 
+// the current values are confirmed with one JSON message to "%CONFIRM% / group / CONFIG_PARAMS_MQTT_BULK_KEY". 
+// The retained topics of the parameters are republished too, through the publish queue if it is enabled
+#ifndef CONFIG_PARAMS_MQTT_BULK
+#define CONFIG_PARAMS_MQTT_BULK 0
+#endif // CONFIG_PARAMS_MQTT_BULK
+#ifndef CONFIG_PARAMS_MQTT_BULK_KEY
+#define CONFIG_PARAMS_MQTT_BULK_KEY "$bulk"
+#endif // CONFIG_PARAMS_MQTT_BULK_KEY
+#ifndef CONFIG_MESSAGE_TG_PARAM_BULK
+#define CONFIG_MESSAGE_TG_PARAM_BULK "🔄 <b>Parameters changed</b>\n\n<i>%s</i> (<code>%s</code>): %d changed, %d rejected"
+#endif // CONFIG_MESSAGE_TG_PARAM_BULK
+
+// Binary values for parameters and groups marked with paramsSetBinary() / paramsSetGroupBinary(): the message is 
+// one byte of param_type_t followed by the value in little-endian byte order (strings are always sent as text). 
+// Incoming messages of this form are applied without text conversion, other messages are still parsed as text. 
+// Outgoing values are published in the same form via the function set by paramsMqttSetPublishBinary()
+#ifndef CONFIG_PARAMS_MQTT_BINARY
+#define CONFIG_PARAMS_MQTT_BINARY 0
+#endif // CONFIG_PARAMS_MQTT_BINARY
+
+// Telegram notifications about parameter changes are collected for CONFIG_PARAMS_TELEGRAM_DIGEST_WINDOW ms and sent 
+// as one message with lines "group / parameter (group.key): old → new". The message is created by the timer outside 
+// of the locks; notifications over CONFIG_PARAMS_TELEGRAM_DIGEST_LIMIT per window are only counted
+#ifndef CONFIG_PARAMS_TELEGRAM_DIGEST
+#define CONFIG_PARAMS_TELEGRAM_DIGEST 0
+#endif // CONFIG_PARAMS_TELEGRAM_DIGEST
+#ifndef CONFIG_PARAMS_TELEGRAM_DIGEST_WINDOW
+#define CONFIG_PARAMS_TELEGRAM_DIGEST_WINDOW 5000
+#endif // CONFIG_PARAMS_TELEGRAM_DIGEST_WINDOW
+#ifndef CONFIG_PARAMS_TELEGRAM_DIGEST_LIMIT
+#define CONFIG_PARAMS_TELEGRAM_DIGEST_LIMIT 32
+#endif // CONFIG_PARAMS_TELEGRAM_DIGEST_LIMIT
+#ifndef CONFIG_PARAMS_TELEGRAM_DIGEST_SIZE
+#define CONFIG_PARAMS_TELEGRAM_DIGEST_SIZE 2048
+#endif // CONFIG_PARAMS_TELEGRAM_DIGEST_SIZE
+#ifndef CONFIG_MESSAGE_TG_PARAM_DIGEST
+#define CONFIG_MESSAGE_TG_PARAM_DIGEST "⚙️ <b>Parameters changed</b>\n\n%s"
+#endif // CONFIG_MESSAGE_TG_PARAM_DIGEST
+
+// Maximum number of topics in one batch of subscriptions on (re)connect. Topics are grouped by qos, 
+// a batch is passed to the MQTT client with one call (one SUBSCRIBE packet, see paramsMqttSetSubscribeBatch())
+#ifndef CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH
+#define CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH 16
+#endif // CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH
+
+// The broker keeps subscriptions between connections (clean session is disabled). Subscriptions are not reset when 
+// the connection is lost, and after reconnecting only parameters that have not yet been subscribed are subscribed
+#ifndef CONFIG_PARAMS_MQTT_PERSISTENT_SESSION
+#define CONFIG_PARAMS_MQTT_PERSISTENT_SESSION 0
+#endif // CONFIG_PARAMS_MQTT_PERSISTENT_SESSION
+
+// Flow control of subscriptions on (re)connect: when the MQTT outbox grows above the high watermark (bytes), 
+// subscribing is paused until it drains below the low watermark, but no longer than the timeout (ms)
+#ifndef CONFIG_PARAMS_MQTT_OUTBOX_HIGH
+#define CONFIG_PARAMS_MQTT_OUTBOX_HIGH 1024
+#endif // CONFIG_PARAMS_MQTT_OUTBOX_HIGH
+#ifndef CONFIG_PARAMS_MQTT_OUTBOX_LOW
+#define CONFIG_PARAMS_MQTT_OUTBOX_LOW 256
+#endif // CONFIG_PARAMS_MQTT_OUTBOX_LOW
+#ifndef CONFIG_PARAMS_MQTT_OUTBOX_TIMEOUT
+#define CONFIG_PARAMS_MQTT_OUTBOX_TIMEOUT 10000
+#endif // CONFIG_PARAMS_MQTT_OUTBOX_TIMEOUT
+
+// Export of all parameters: size of the buffer through which the document is passed to the writer, 
+// maximum length of exported string values, key of the topic "%CONFIRM% / key" for publishing the export 
+// and the command that requests it
+#ifndef CONFIG_PARAMS_EXPORT_BUFFER_SIZE
+#define CONFIG_PARAMS_EXPORT_BUFFER_SIZE 128
+#endif // CONFIG_PARAMS_EXPORT_BUFFER_SIZE
+#ifndef CONFIG_PARAMS_EXPORT_STRING_SIZE
+#define CONFIG_PARAMS_EXPORT_STRING_SIZE 128
+#endif // CONFIG_PARAMS_EXPORT_STRING_SIZE
+#ifndef CONFIG_PARAMS_MQTT_EXPORT_KEY
+#define CONFIG_PARAMS_MQTT_EXPORT_KEY "$export"
+#endif // CONFIG_PARAMS_MQTT_EXPORT_KEY
+#ifndef CONFIG_MQTT_CMD_PARAMS_EXPORT
+#define CONFIG_MQTT_CMD_PARAMS_EXPORT "params_export"
+#endif // CONFIG_MQTT_CMD_PARAMS_EXPORT
+
+// Suspend the scheduler while a new value is being written to the variable. This protects code
+// that reads variables directly; paramsReadXXX() functions are consistent without it
+#ifndef CONFIG_PARAMS_SUSPEND_SCHEDULER
+#define CONFIG_PARAMS_SUSPEND_SCHEDULER 1
+#endif // CONFIG_PARAMS_SUSPEND_SCHEDULER
+
 typedef enum {
   PARAM_NVS_RESTORED = 0,
   PARAM_SET_INTERNAL,
@@ -51,38 +226,159 @@ class param_handler_t {
     virtual void onChange(param_change_mode_t mode) = 0;
 };
 
+// Storage for a scalar value of any supported type
+typedef union {
+  int8_t   i8;
+  uint8_t  u8;
+  int16_t  i16;
+  uint16_t u16;
+  int32_t  i32;
+  uint32_t u32;
+  int64_t  i64;
+  uint64_t u64;
+  float    f;
+  double   d;
+} paramsValue_t;
+
 typedef struct paramsGroup_t {
   paramsGroup_t *parent;
   char *key;
   char *topic;
   char *friendly;
+  uint32_t key_hash;
+  paramsGroup_t *key_next;
+  void *lock;
+  char **topic_prefix;
+  char *topic_bulk;
+  char *topic_bulk_confirm;
+  bool bulk_subscribed;
+  bool binary;
   STAILQ_ENTRY(paramsGroup_t) next;
 } paramsGroup_t;
 typedef struct paramsGroup_t *paramsGroupHandle_t;
 
-typedef struct paramsEntry_t {
-  param_kind_t type_param;
-  param_type_t type_value;
+struct paramsEntry_t;
+typedef void (*params_callback_t) (struct paramsEntry_t* item, param_change_mode_t mode, void* value);
+
+// Operations on values of one type. For typed parameters (paramsEntry<T>) they are generated at compile time 
+// and replace the functions of rTypes, which select the type at runtime
+typedef struct paramsValueOps_t {
+  bool (*parse)(const char* text, void* value);
+  bool (*equal)(const void* value1, const void* value2);
+  bool (*check)(const void* value, const paramsValue_t* min_value, const paramsValue_t* max_value);
+  void (*assign)(void* dest, const void* src);
+  int (*format)(const void* value, char* buf, size_t size);
+} paramsValueOps_t;
+
+// Rarely used data of the parameter: handlers and limits. It does not change after registration 
+// (except for the limits), so it can be located in flash as part of a table of descriptors
+typedef struct paramsEntryMeta_t {
   param_handler_type_t type_handler;
-  void *handler;
-  paramsGroup_t *group;
-  uint32_t id;
+  union {
+    void *handler;
+    params_callback_t callback;
+    param_handler_t *object;
+  };
   const char *friendly;
-  const char *key;
+  bool has_limits;
+  uint8_t qos;
+  paramsValue_t min_value;
+  paramsValue_t max_value;
+  const paramsValueOps_t *ops;
+} paramsEntryMeta_t;
+
+// Data of the parameter used when processing each message and when scanning the list
+typedef struct paramsEntry_t {
+  // Set once at registration, they can share one word
+  param_kind_t type_param : 8;
+  param_type_t type_value : 8;
+  bool meta_const : 1;
+  bool binary : 1;
+  // Written from different tasks and under different locks, each flag occupies its own byte
+  bool subscribed;
+  bool locked;
+  bool notify;
+  bool dirty;
+  bool restore_pending;
+  bool publish_pending;
+  bool update_pending;
+  bool update_handler;
+  uint32_t seq;
   void *value;
-  void *min_value;
-  void *max_value;
+  paramsGroup_t *group;
+  const char *key;
   char *topic_subscribe;
   char *topic_publish;
-  bool subscribed = false;
-  bool locked = false;
-  bool notify = true;
-  int  qos;
+  uint32_t topic_hash;
+  paramsEntry_t *topic_next;
+  uint32_t key_hash;
+  paramsEntry_t *key_next;
+  const paramsEntryMeta_t *meta;
   STAILQ_ENTRY(paramsEntry_t) next;
 } paramsEntry_t;
 typedef struct paramsEntry_t *paramsEntryHandle_t;
 
-typedef void (*params_callback_t) (paramsEntryHandle_t item, param_change_mode_t mode, void* value);
+// Descriptor of a parameter known at compile time. Tables of descriptors can be declared as constexpr 
+// and stay in flash, only paramsEntry_t with the runtime state is created in RAM during registration:
+//
+//   static constexpr paramsDescriptor_t tblHeater[] = {
+//     PARAMS_DESCRIPTOR(OPT_KIND_PARAMETER, OPT_TYPE_U8, "mode", "Mode", 1, &heaterMode),
+//     PARAMS_DESCRIPTOR_LIMITS(OPT_KIND_PARAMETER, OPT_TYPE_FLOAT, "temp", "Temperature", 1, &heaterTemp, f, 5.0, 30.0),
+//   };
+//   paramsRegisterTable(pgHeater, tblHeater, sizeof(tblHeater) / sizeof(tblHeater[0]), nullptr);
+typedef struct paramsDescriptor_t {
+  param_kind_t type_param;
+  param_type_t type_value;
+  const char *key;
+  void *value;
+  paramsEntryMeta_t meta;
+} paramsDescriptor_t;
+
+// Parameter without limits, changes are posted to the event loop
+#define PARAMS_DESCRIPTOR(type_param, type_value, name_key, name_friendly, qos, value) \
+  { type_param, type_value, name_key, value, { PARAM_HANDLER_EVENT, { nullptr }, name_friendly, false, qos, {}, {}, nullptr } }
+// Parameter with limits, field is the member of paramsValue_t for the type of the value (i8, u8 ... f, d)
+#define PARAMS_DESCRIPTOR_LIMITS(type_param, type_value, name_key, name_friendly, qos, value, field, min_value, max_value) \
+  { type_param, type_value, name_key, value, { PARAM_HANDLER_EVENT, { nullptr }, name_friendly, true, qos, \
+    { .field = (min_value) }, { .field = (max_value) }, nullptr } }
+// Parameter without limits with a callback function
+#define PARAMS_DESCRIPTOR_CALLBACK(type_param, type_value, name_key, name_friendly, qos, value, change_callback) \
+  { type_param, type_value, name_key, value, { PARAM_HANDLER_CALLBACK, { .callback = change_callback }, name_friendly, false, qos, {}, {}, nullptr } }
+
+// Subscription to several topics with one SUBSCRIBE packet (for example, using esp_mqtt_client_subscribe_multiple())
+typedef bool (*params_subscribe_batch_t)(const char** topics, const int* qos, size_t count);
+
+// Publishing of a binary payload (the payload may contain zero bytes, so its length is passed explicitly)
+typedef bool (*params_publish_binary_t)(const char* topic, const uint8_t* data, size_t len, int qos, bool retained);
+
+// Format of the exported document: { "group": { "key": value, ... }, ... }
+typedef enum {
+  PARAMS_EXPORT_JSON = 0,
+  PARAMS_EXPORT_CBOR
+} params_export_format_t;
+
+// Receives the next part of the exported document, returns false to stop the export
+typedef bool (*params_export_writer_t)(const uint8_t* data, size_t size, void* ctx);
+
+// Statistics of the flow control of subscriptions
+typedef struct {
+  uint32_t throttled;       // number of pauses to drain the outbox
+  uint32_t throttled_ms;    // total time of pauses
+  uint32_t timeouts;        // pauses interrupted by CONFIG_PARAMS_MQTT_OUTBOX_TIMEOUT
+  uint32_t drain_rate;      // estimated outbox drain rate, bytes per second
+} paramsFlowStats_t;
+
+// Memory used by the registry of parameters
+typedef struct {
+  uint32_t entries;
+  uint32_t groups;
+  size_t entries_bytes;     // hot data and metadata of the parameters
+  size_t groups_bytes;
+  size_t topics_bytes;      // MQTT topics arena
+  size_t index_bytes;       // hash indexes
+  size_t total_bytes;
+  size_t bytes_per_param;
+} paramsMemoryStats_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -108,6 +404,20 @@ paramsEntryHandle_t paramsRegisterCommonValueEx(const param_kind_t type_param, c
 #define paramsRegisterCommonValue(type_param, type_value, change_handler, name_key, name_friendly, qos, value) \
   paramsRegisterCommonValueEx(type_param, type_value, PARAM_HANDLER_EVENT, change_handler, name_key, name_friendly, qos, value)
 
+// Register all parameters of the table with one call. Descriptors must remain valid while the parameters exist 
+// (static or constexpr tables). If entries is not nullptr, it receives the handles of the parameters
+bool paramsRegisterTable(paramsGroupHandle_t parent_group, const paramsDescriptor_t* table, size_t count, paramsEntryHandle_t* entries);
+
+// Search for registered groups and parameters by key (group_key is the full key, for example "parent.child")
+paramsGroupHandle_t paramsFindGroup(const char* group_key);
+paramsEntryHandle_t paramsFind(const char* group_key, const char* key);
+
+// Number of change notifications lost due to handler queue overflow (CONFIG_PARAMS_HANDLER_ASYNC)
+uint32_t paramsHandlerDropped();
+
+// Restore values of all registered parameters from NVS (when CONFIG_PARAMS_NVS_DEFERRED_RESTORE is enabled)
+void paramsRestoreAll();
+
 void paramsSetLimitsI8(paramsEntryHandle_t entry, int8_t min_value, int8_t max_value);
 void paramsSetLimitsU8(paramsEntryHandle_t entry, uint8_t min_value, uint8_t max_value);
 void paramsSetLimitsI16(paramsEntryHandle_t entry, int16_t min_value, int16_t max_value);
@@ -119,16 +429,64 @@ void paramsSetLimitsU64(paramsEntryHandle_t entry, uint64_t min_value, uint64_t
 void paramsSetLimitsFloat(paramsEntryHandle_t entry, float min_value, float max_value);
 void paramsSetLimitsDouble(paramsEntryHandle_t entry, double min_value, double max_value);
 
+// Process values of the parameter with type-specific functions instead of generic ones (used by paramsEntry<T>)
+void paramsSetValueOps(paramsEntryHandle_t entry, const paramsValueOps_t* ops);
+
+// Binary values in MQTT messages for the parameter or for all parameters of the group (CONFIG_PARAMS_MQTT_BINARY)
+void paramsSetBinary(paramsEntryHandle_t entry, bool binary);
+void paramsSetGroupBinary(paramsGroupHandle_t group, bool binary);
+
 void paramsMqttSubscribe(paramsEntryHandle_t entry);
 void paramsMqttUnsubscribe(paramsEntryHandle_t entry);
 void paramsMqttPublish(paramsEntryHandle_t entry, bool publish_in_mqtt);
 
+// Consistent reading of the current value (value is re-read if it was changed during reading)
+bool paramsReadValue(paramsEntryHandle_t entry, void* value, size_t size);
+bool paramsReadI8(paramsEntryHandle_t entry, int8_t* value);
+bool paramsReadU8(paramsEntryHandle_t entry, uint8_t* value);
+bool paramsReadI16(paramsEntryHandle_t entry, int16_t* value);
+bool paramsReadU16(paramsEntryHandle_t entry, uint16_t* value);
+bool paramsReadI32(paramsEntryHandle_t entry, int32_t* value);
+bool paramsReadU32(paramsEntryHandle_t entry, uint32_t* value);
+bool paramsReadI64(paramsEntryHandle_t entry, int64_t* value);
+bool paramsReadU64(paramsEntryHandle_t entry, uint64_t* value);
+bool paramsReadFloat(paramsEntryHandle_t entry, float* value);
+bool paramsReadDouble(paramsEntryHandle_t entry, double* value);
+bool paramsReadString(paramsEntryHandle_t entry, char* buffer, size_t size);
+
 void paramsValueStore(paramsEntryHandle_t entry, const bool callHandler);
+// Write a new value to the variable of the parameter, then save and publish it like paramsValueStore()
+bool paramsValueWrite(paramsEntryHandle_t entry, const void* value, size_t size, const bool callHandler);
+// Write all pending changes to NVS immediately (before reboot or shutdown)
+void paramsFlush();
+
+// Transaction of local changes: inside it paramsValueStore() and paramsValueWrite() of the calling task only change 
+// values, and saving, handlers and publishing are performed by paramsCommitUpdate() (one NVS commit per group). 
+// paramsAbortUpdate() restores the values saved before their first change by paramsValueWrite(); values changed 
+// directly in the variable are read from NVS. It returns false if some values could not be restored, their changes 
+// are committed. Transactions can be nested, only the outer one is committed or aborted
+void paramsBeginUpdate();
+bool paramsCommitUpdate();
+bool paramsAbortUpdate();
+
+// Memory used by the registry of parameters
+void paramsMemoryStats(paramsMemoryStats_t* stats);
+
+// Export current values of all parameters. The document is passed to the writer in parts through a small buffer 
+// and is not created in the heap. Returns false if the writer stopped the export
+bool paramsExport(params_export_writer_t writer, void* ctx, params_export_format_t format);
+// Publish the export in JSON format with one message (also by the command CONFIG_MQTT_CMD_PARAMS_EXPORT)
+bool paramsMqttExport();
 void paramsValueSet(paramsEntryHandle_t entry, char *new_value, bool publish_in_mqtt);
 
 // Functions for working with the MQTT broker directly
 // Note: usually they are not needed, they will be called automatically when the corresponding event is received
 void paramsMqttSubscribesOpen(bool mqttPrimary, bool forcedResubscribe);
+// Function for subscribing to a batch of topics. If it is not set, topics of a batch are subscribed one by one
+void paramsMqttSetSubscribeBatch(params_subscribe_batch_t subscribe);
+// Function for publishing binary values. If it is not set, all values are published as text
+void paramsMqttSetPublishBinary(params_publish_binary_t publish);
+void paramsMqttFlowStats(paramsFlowStats_t* stats);
 void paramsMqttSubscribesClose();
 void paramsMqttIncomingMessage(char *topic, char *payload, size_t len);
 
@@ -139,4 +497,218 @@ bool paramsEventHandlerRegister();
 }
 #endif
 
-#endif // __RE_PARAMS_H__
\ No newline at end of file
+// Type of the value for each supported C++ type. Other types have no definition, 
+// so registering a variable of the wrong type is a compile-time error
+template <typename T> struct paramsTypeOf;
+
+#define PARAMS_TYPE_OF(type_c, type_id, set_limits) \
+  template <> struct paramsTypeOf<type_c> { \
+    static constexpr param_type_t type = type_id; \
+    static void setLimits(paramsEntryHandle_t entry, type_c min_value, type_c max_value) \
+      { set_limits(entry, min_value, max_value); } \
+  };
+
+PARAMS_TYPE_OF(int8_t, OPT_TYPE_I8, paramsSetLimitsI8)
+PARAMS_TYPE_OF(uint8_t, OPT_TYPE_U8, paramsSetLimitsU8)
+PARAMS_TYPE_OF(int16_t, OPT_TYPE_I16, paramsSetLimitsI16)
+PARAMS_TYPE_OF(uint16_t, OPT_TYPE_U16, paramsSetLimitsU16)
+PARAMS_TYPE_OF(int32_t, OPT_TYPE_I32, paramsSetLimitsI32)
+PARAMS_TYPE_OF(uint32_t, OPT_TYPE_U32, paramsSetLimitsU32)
+PARAMS_TYPE_OF(int64_t, OPT_TYPE_I64, paramsSetLimitsI64)
+PARAMS_TYPE_OF(uint64_t, OPT_TYPE_U64, paramsSetLimitsU64)
+PARAMS_TYPE_OF(float, OPT_TYPE_FLOAT, paramsSetLimitsFloat)
+PARAMS_TYPE_OF(double, OPT_TYPE_DOUBLE, paramsSetLimitsDouble)
+
+inline bool _paramsTextEnd(const char* end)
+{
+  while (isspace((unsigned char)*end)) end++;
+  return *end == '\0';
+}
+
+// Strict conversion of the text, the same rules as for generic parameters
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, bool>::type
+  _paramsTextParse(const char* str, T* value)
+{
+  char* end = nullptr;
+  errno = 0;
+  long long v = strtoll(str, &end, 10);
+  if ((end == str) || (errno != 0) || !_paramsTextEnd(end)) return false;
+  if ((v < (long long)std::numeric_limits<T>::min()) || (v > (long long)std::numeric_limits<T>::max())) return false;
+  *value = (T)v;
+  return true;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, bool>::type
+  _paramsTextParse(const char* str, T* value)
+{
+  char* end = nullptr;
+  errno = 0;
+  while (isspace((unsigned char)*str)) str++;
+  if (*str == '-') return false;
+  unsigned long long v = strtoull(str, &end, 10);
+  if ((end == str) || (errno != 0) || !_paramsTextEnd(end)) return false;
+  if (v > (unsigned long long)std::numeric_limits<T>::max()) return false;
+  *value = (T)v;
+  return true;
+}
+
+inline bool _paramsTextParse(const char* str, float* value)
+{
+  char* end = nullptr;
+  errno = 0;
+  *value = strtof(str, &end);
+  return (end != str) && (errno == 0) && _paramsTextEnd(end);
+}
+
+inline bool _paramsTextParse(const char* str, double* value)
+{
+  char* end = nullptr;
+  errno = 0;
+  *value = strtod(str, &end);
+  return (end != str) && (errno == 0) && _paramsTextEnd(end);
+}
+
+// Numbers are printed directly, floating point numbers in the same format as value2string(). If the text does not 
+// fit into the buffer, value2string() is used
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type
+  _paramsTextFormat(T value, char* buf, size_t size)
+{
+  return snprintf(buf, size, "%" PRIi64, (int64_t)value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, int>::type
+  _paramsTextFormat(T value, char* buf, size_t size)
+{
+  return snprintf(buf, size, "%" PRIu64, (uint64_t)value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, int>::type
+  _paramsTextFormat(T value, char* buf, size_t size)
+{
+  return snprintf(buf, size, "%f", (double)value);
+}
+
+// Operations for the type T, one table per type is placed in flash
+template <typename T>
+struct paramsValueOpsOf {
+  static bool parse(const char* text, void* value) 
+    { return _paramsTextParse(text, (T*)value); }
+  static bool equal(const void* value1, const void* value2) 
+    { return *(const T*)value1 == *(const T*)value2; }
+  static bool check(const void* value, const paramsValue_t* min_value, const paramsValue_t* max_value) 
+    { return (*(const T*)value >= *(const T*)min_value) && (*(const T*)value <= *(const T*)max_value); }
+  static void assign(void* dest, const void* src) 
+    { *(T*)dest = *(const T*)src; }
+  static int format(const void* value, char* buf, size_t size) 
+    { return _paramsTextFormat(*(const T*)value, buf, size); }
+  static const paramsValueOps_t ops;
+};
+
+template <typename T>
+const paramsValueOps_t paramsValueOpsOf<T>::ops = { 
+  paramsValueOpsOf<T>::parse, paramsValueOpsOf<T>::equal, paramsValueOpsOf<T>::check, 
+  paramsValueOpsOf<T>::assign, paramsValueOpsOf<T>::format 
+};
+
+// Typed parameter: the variable is stored in the object, the type is checked at compile time and values 
+// received from MQTT are processed by the functions for this type. The object must exist as long as the parameter:
+//
+//   static void onTempChanged(paramsEntry<float>& param, param_change_mode_t mode, float value) { ... }
+//   static paramsEntry<float> heaterTemp(20.0, onTempChanged);
+//   heaterTemp.registerValue(OPT_KIND_PARAMETER, pgHeater, "temp", "Temperature", 1);
+//   heaterTemp.setLimits(5.0, 30.0);
+template <typename T>
+class paramsEntry: public param_handler_t {
+  public:
+    typedef void (*change_callback_t)(paramsEntry<T>& param, param_change_mode_t mode, T value);
+
+    paramsEntry(T value, change_callback_t callback = nullptr) : _value(value), _callback(callback), _entry(nullptr) {};
+
+    bool registerValue(const param_kind_t type_param, paramsGroupHandle_t parent_group, 
+      const char* name_key, const char* name_friendly, const int qos)
+    {
+      _entry = paramsRegisterValueEx(type_param, paramsTypeOf<T>::type, PARAM_HANDLER_CLASS, this, 
+        parent_group, name_key, name_friendly, qos, &_value);
+      if (_entry) {
+        paramsSetValueOps(_entry, &paramsValueOpsOf<T>::ops);
+      };
+      return _entry != nullptr;
+    };
+
+    void setLimits(T min_value, T max_value)
+    {
+      if (_entry) {
+        paramsTypeOf<T>::setLimits(_entry, min_value, max_value);
+      };
+    };
+
+    // Consistent reading of the current value
+    T get() const
+    {
+      T value = _value;
+      if (_entry) {
+        paramsReadValue(_entry, &value, sizeof(T));
+      };
+      return value;
+    };
+
+    // Change the value from the program: it is saved, published and the callback is called
+    bool set(T value) 
+    {
+      if (_entry) {
+        return paramsValueWrite(_entry, &value, sizeof(T), true);
+      };
+      _value = value;
+      return true;
+    };
+
+    paramsEntryHandle_t handle() const { return _entry; };
+
+    void onChange(param_change_mode_t mode) override
+    {
+      if (_callback) {
+        _callback(*this, mode, get());
+      };
+    };
+  protected:
+    T _value;
+    change_callback_t _callback;
+    paramsEntryHandle_t _entry;
+};
+
+// Scoped transaction: changes are committed when the guard goes out of scope, unless abort() was called
+//   { paramsUpdateGuard update; heaterTemp.set(21.0); heaterMode.set(2); }
+class paramsUpdateGuard {
+  public:
+    paramsUpdateGuard() : _active(true) { paramsBeginUpdate(); };
+    ~paramsUpdateGuard() { commit(); };
+    paramsUpdateGuard(const paramsUpdateGuard&) = delete;
+    paramsUpdateGuard& operator=(const paramsUpdateGuard&) = delete;
+
+    bool commit()
+    {
+      if (_active) {
+        _active = false;
+        return paramsCommitUpdate();
+      };
+      return false;
+    };
+
+    bool abort()
+    {
+      if (_active) {
+        _active = false;
+        return paramsAbortUpdate();
+      };
+      return false;
+    };
+  private:
+    bool _active;
+};
+
+#endif // __RE_PARAMS_H__
@@ -1,8 +1,19 @@
 #include "reParams.h"
 #include <string.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <errno.h>
 #include <time.h>
+#include <math.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/timers.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "nvs.h"
+#if CONFIG_PARAMS_MQTT_BULK
+#include "cJSON.h"
+#endif // CONFIG_PARAMS_MQTT_BULK
 
 STAILQ_HEAD(paramsGroupHead_t, paramsGroup_t);
 STAILQ_HEAD(paramsEntryHead_t, paramsEntry_t);
@@ -11,114 +22,1491 @@ typedef struct paramsGroupHead_t *paramsGroupHeadHandle_t;
 
 static paramsGroupHeadHandle_t paramsGroups = nullptr;
 static paramsEntryHeadHandle_t paramsList = nullptr;
+// paramsLock protects the structure of the lists and subscriptions, the values of the parameters are protected 
+// by the lock of their group (paramsSysLock for parameters without a group), topic index - by paramsIndexLock.
+// Lock order: paramsLock -> group lock -> paramsIndexLock. The pool of metadata is protected by paramsMetaLock, 
+// nothing else is locked while it is held
 static SemaphoreHandle_t paramsLock = nullptr;
+static SemaphoreHandle_t paramsSysLock = nullptr;
+static SemaphoreHandle_t paramsIndexLock = nullptr;
+static SemaphoreHandle_t paramsMetaLock = nullptr;
+// Only one subscription pass runs at a time, it takes paramsLock only for short steps.
+// Lock order: paramsSubscribeLock -> paramsLock
+static SemaphoreHandle_t paramsSubscribeLock = nullptr;
+static paramsEntryHandle_t _paramsResubscribeNext = nullptr;
+static uint32_t _paramsResubscribePass = 0;
+static SemaphoreHandle_t paramsUpdateLock = nullptr;
+static TaskHandle_t _paramsUpdateTask = nullptr;
+static uint16_t _paramsUpdateDepth = 0;
+static bool _paramsUpdateAborted = false;
+// Value of the parameter before its first change in the transaction, it is restored by paramsAbortUpdate()
+typedef struct paramsUpdateSaved_t {
+  paramsEntryHandle_t entry;
+  paramsValue_t value;
+  struct paramsUpdateSaved_t *next;
+} paramsUpdateSaved_t;
+static paramsUpdateSaved_t* _paramsUpdateSaved = nullptr;
+static paramsEntryHandle_t* paramsTopicIndex = nullptr;
+static paramsEntryHandle_t* paramsKeyIndex = nullptr;
+static paramsGroupHandle_t* paramsGroupIndex = nullptr;
+static bool _paramsTopicsComplete = false;
+#if CONFIG_PARAMS_NVS_DELAYED_WRITE
+static TimerHandle_t paramsNvsTimer = nullptr;
+#endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+// Background work is done by the worker task, timers only set the bits of its notification value
+#define PARAMS_WORKER_ENABLED (CONFIG_PARAMS_NVS_DELAYED_WRITE || CONFIG_PARAMS_MQTT_PUBLISH_QUEUE \
+  || (CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST))
+#if PARAMS_WORKER_ENABLED
+#define PARAMS_WORK_NVS_FLUSH (1UL << 0)
+#define PARAMS_WORK_PUBLISH   (1UL << 1)
+#define PARAMS_WORK_DIGEST    (1UL << 2)
+static TaskHandle_t paramsWorkerTask = nullptr;
+#endif // PARAMS_WORKER_ENABLED
+#if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+static TimerHandle_t paramsPublishTimer = nullptr;
+static paramsEntryHandle_t _paramsPublishNext = nullptr;
+static void paramsPublishTimerCallback(TimerHandle_t timer);
+static void _paramsPublishPending();
+#endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+#if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+// Kind of the notification about the parameter change
+typedef enum {
+  PARAMS_NOTIFY_CHANGED = 0,
+  PARAMS_NOTIFY_EQUAL,
+  PARAMS_NOTIFY_INVALID,
+  PARAMS_NOTIFY_BAD
+} params_notify_kind_t;
+#if CONFIG_PARAMS_TELEGRAM_DIGEST
+static QueueHandle_t paramsDigestQueue = nullptr;
+static TimerHandle_t paramsDigestTimer = nullptr;
+static uint32_t _paramsDigestDropped = 0;
+static void paramsDigestTimerCallback(TimerHandle_t timer);
+static void _paramsDigestSend();
+static bool _paramsDigestTimerCreate();
+static void _paramsDigestTimerDelete();
+#endif // CONFIG_PARAMS_TELEGRAM_DIGEST
+#endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+#if CONFIG_PARAMS_HANDLER_ASYNC
+static QueueHandle_t paramsHandlerQueue = nullptr;
+static TaskHandle_t paramsHandlerTask = nullptr;
+#endif // CONFIG_PARAMS_HANDLER_ASYNC
+static uint32_t _paramsHandlerDropped = 0;
 
 #define OPTIONS_LOCK() xSemaphoreTake(paramsLock, portMAX_DELAY)
 #define OPTIONS_UNLOCK() xSemaphoreGive(paramsLock)
+#define ENTRY_LOCK(entry) xSemaphoreTake(_paramsEntryLock(entry), portMAX_DELAY)
+#define ENTRY_UNLOCK(entry) xSemaphoreGive(_paramsEntryLock(entry))
+#define GROUP_LOCK(group) xSemaphoreTake(_paramsGroupLock(group), portMAX_DELAY)
+#define GROUP_UNLOCK(group) xSemaphoreGive(_paramsGroupLock(group))
+#define INDEX_LOCK() xSemaphoreTake(paramsIndexLock, portMAX_DELAY)
+#define INDEX_UNLOCK() xSemaphoreGive(paramsIndexLock)
 
 static const char* logTAG = "PRMS";
 
 static bool _paramsMqttPrimary = true;
+static uint32_t _paramsMqttIdentity = 0;
 #if CONFIG_MQTT_PARAMS_WILDCARD
 static char* _paramsWildcardTopic = nullptr;
+static size_t _paramsWildcardPrefixLen = 0;
 #endif // CONFIG_MQTT_PARAMS_WILDCARD
 
 paramsGroupHandle_t _pgCommon = nullptr;
 
+static inline SemaphoreHandle_t _paramsGroupLock(paramsGroupHandle_t group)
+{
+  if ((group) && (group->lock)) {
+    return (SemaphoreHandle_t)group->lock;
+  };
+  return paramsSysLock;
+}
+
+static inline SemaphoreHandle_t _paramsEntryLock(paramsEntryHandle_t entry)
+{
+  return _paramsGroupLock(entry->group);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------- Reading values ----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// The sequence counter is odd while the value is being changed (writers are serialized by the parameters lock)
+static void _paramsValueWriteBegin(paramsEntryHandle_t entry)
+{
+  __atomic_store_n(&entry->seq, entry->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void _paramsValueWriteEnd(paramsEntryHandle_t entry)
+{
+  __atomic_store_n(&entry->seq, entry->seq + 1, __ATOMIC_RELEASE);
+}
+
+static size_t _paramsValueSize(param_type_t type_value)
+{
+  switch (type_value) {
+    case OPT_TYPE_I8:     return sizeof(int8_t);
+    case OPT_TYPE_U8:     return sizeof(uint8_t);
+    case OPT_TYPE_I16:    return sizeof(int16_t);
+    case OPT_TYPE_U16:    return sizeof(uint16_t);
+    case OPT_TYPE_I32:    return sizeof(int32_t);
+    case OPT_TYPE_U32:    return sizeof(uint32_t);
+    case OPT_TYPE_I64:    return sizeof(int64_t);
+    case OPT_TYPE_U64:    return sizeof(uint64_t);
+    case OPT_TYPE_FLOAT:  return sizeof(float);
+    case OPT_TYPE_DOUBLE: return sizeof(double);
+    default:              return 0;
+  };
+}
+
+static bool _paramsValueRead(paramsEntryHandle_t entry, void* value, size_t size, bool is_string)
+{
+  if ((entry) && (entry->value) && (value) && (size > 0)) {
+    uint8_t attempt = 0;
+    while (1) {
+      uint32_t seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+      if ((seq & 1) == 0) {
+        if (is_string) {
+          strncpy((char*)value, (const char*)entry->value, size - 1);
+          ((char*)value)[size - 1] = '\0';
+        } else {
+          memcpy(value, entry->value, size);
+        };
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&entry->seq, __ATOMIC_RELAXED) == seq) {
+          return true;
+        };
+      };
+      // The writer may have been preempted by this task, let it finish
+      if (++attempt >= 8) {
+        attempt = 0;
+        vTaskDelay(1);
+      };
+    };
+  };
+  return false;
+}
+
+bool paramsReadValue(paramsEntryHandle_t entry, void* value, size_t size)
+{
+  if ((entry) && (size == _paramsValueSize(entry->type_value))) {
+    return _paramsValueRead(entry, value, size, false);
+  };
+  return false;
+}
+
+#define PARAMS_READ_TYPED(name, type_c, type_id) \
+  bool name(paramsEntryHandle_t entry, type_c* value) \
+  { \
+    if ((entry) && (entry->type_value == type_id)) { \
+      return _paramsValueRead(entry, value, sizeof(type_c), false); \
+    }; \
+    return false; \
+  }
+
+PARAMS_READ_TYPED(paramsReadI8, int8_t, OPT_TYPE_I8)
+PARAMS_READ_TYPED(paramsReadU8, uint8_t, OPT_TYPE_U8)
+PARAMS_READ_TYPED(paramsReadI16, int16_t, OPT_TYPE_I16)
+PARAMS_READ_TYPED(paramsReadU16, uint16_t, OPT_TYPE_U16)
+PARAMS_READ_TYPED(paramsReadI32, int32_t, OPT_TYPE_I32)
+PARAMS_READ_TYPED(paramsReadU32, uint32_t, OPT_TYPE_U32)
+PARAMS_READ_TYPED(paramsReadI64, int64_t, OPT_TYPE_I64)
+PARAMS_READ_TYPED(paramsReadU64, uint64_t, OPT_TYPE_U64)
+PARAMS_READ_TYPED(paramsReadFloat, float, OPT_TYPE_FLOAT)
+PARAMS_READ_TYPED(paramsReadDouble, double, OPT_TYPE_DOUBLE)
+
+bool paramsReadString(paramsEntryHandle_t entry, char* buffer, size_t size)
+{
+  if ((entry) && (entry->type_value == OPT_TYPE_STRING)) {
+    return _paramsValueRead(entry, buffer, size, true);
+  };
+  return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// -------------------------------------------------- Formatting values --------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// Text representation of the value: numbers are printed to the buffer (by the typed function, if any), 
+// strings are used as is. Only values that do not fit into the buffer are converted by value2string() into a heap copy
+typedef struct {
+  char buf[CONFIG_PARAMS_FORMAT_BUFFER_SIZE];
+  char* heap;
+} paramsValueText_t;
+
+// Format a value of the parameter type (not necessarily the current one)
+static char* _paramsValueFormatFrom(paramsEntryHandle_t entry, void* value, paramsValueText_t* text)
+{
+  text->heap = nullptr;
+  if (value == nullptr) return nullptr;
+  int len = -1;
+  if (entry->meta->ops) {
+    len = entry->meta->ops->format(value, text->buf, sizeof(text->buf));
+  } else switch (entry->type_value) {
+    case OPT_TYPE_I8:  len = snprintf(text->buf, sizeof(text->buf), "%d", *(int8_t*)value); break;
+    case OPT_TYPE_U8:  len = snprintf(text->buf, sizeof(text->buf), "%u", *(uint8_t*)value); break;
+    case OPT_TYPE_I16: len = snprintf(text->buf, sizeof(text->buf), "%d", *(int16_t*)value); break;
+    case OPT_TYPE_U16: len = snprintf(text->buf, sizeof(text->buf), "%u", *(uint16_t*)value); break;
+    case OPT_TYPE_I32: len = snprintf(text->buf, sizeof(text->buf), "%" PRIi32, *(int32_t*)value); break;
+    case OPT_TYPE_U32: len = snprintf(text->buf, sizeof(text->buf), "%" PRIu32, *(uint32_t*)value); break;
+    case OPT_TYPE_I64: len = snprintf(text->buf, sizeof(text->buf), "%" PRIi64, *(int64_t*)value); break;
+    case OPT_TYPE_U64: len = snprintf(text->buf, sizeof(text->buf), "%" PRIu64, *(uint64_t*)value); break;
+    // The same format as value2string()
+    case OPT_TYPE_FLOAT:  len = snprintf(text->buf, sizeof(text->buf), "%f", *(float*)value); break;
+    case OPT_TYPE_DOUBLE: len = snprintf(text->buf, sizeof(text->buf), "%f", *(double*)value); break;
+    case OPT_TYPE_STRING: return (char*)value;
+    default: break;
+  };
+  if ((len >= 0) && (len < (int)sizeof(text->buf))) {
+    return text->buf;
+  };
+  text->heap = value2string(entry->type_value, value);
+  return text->heap;
+}
+
+static char* _paramsValueFormat(paramsEntryHandle_t entry, paramsValueText_t* text)
+{
+  return _paramsValueFormatFrom(entry, entry->value, text);
+}
+
+static void _paramsValueTextFree(paramsValueText_t* text)
+{
+  if (text->heap) {
+    free(text->heap);
+    text->heap = nullptr;
+  };
+}
+
+#if CONFIG_PARAMS_MQTT_BINARY
+
+// Binary representation of the value: one byte of param_type_t and the value in little-endian byte order 
+// (as it is stored in memory on ESP32)
+#define PARAMS_BINARY_SIZE_MAX (1 + sizeof(paramsValue_t))
+
+static bool _paramsIsBinary(paramsEntryHandle_t entry)
+{
+  return (entry->binary || ((entry->group) && (entry->group->binary))) 
+      && (entry->value) && (_paramsValueSize(entry->type_value) > 0);
+}
+
+static size_t _paramsValueEncode(paramsEntryHandle_t entry, uint8_t* data)
+{
+  size_t size = _paramsValueSize(entry->type_value);
+  data[0] = (uint8_t)entry->type_value;
+  memcpy(data + 1, entry->value, size);
+  return size + 1;
+}
+
+// Returns false if the payload is not a binary value of the parameter type (then it is processed as text)
+static bool _paramsValueDecode(paramsEntryHandle_t entry, const char* payload, size_t len, paramsValue_t* value)
+{
+  size_t size = _paramsValueSize(entry->type_value);
+  if ((size == 0) || (len != size + 1) || ((uint8_t)payload[0] != (uint8_t)entry->type_value)) return false;
+  memcpy(value, payload + 1, size);
+  return true;
+}
+
+#endif // CONFIG_PARAMS_MQTT_BINARY
+
+// -----------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------- Parsing values ----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+static bool _paramsParseEnd(const char* end)
+{
+  while (isspace((unsigned char)*end)) end++;
+  return *end == '\0';
+}
+
+// Strict conversion of the text to a scalar value without using the heap, 
+// returns false if the text is not a number or does not fit into the type
+static bool _paramsValueParse(param_type_t type_value, const char* str, paramsValue_t* value)
+{
+  char* end = nullptr;
+  errno = 0;
+  switch (type_value) {
+    case OPT_TYPE_I8: case OPT_TYPE_I16: case OPT_TYPE_I32: case OPT_TYPE_I64:
+    {
+      long long v = strtoll(str, &end, 10);
+      if ((end == str) || (errno != 0) || !_paramsParseEnd(end)) return false;
+      switch (type_value) {
+        case OPT_TYPE_I8:  if ((v < INT8_MIN) || (v > INT8_MAX)) return false; value->i8 = (int8_t)v; break;
+        case OPT_TYPE_I16: if ((v < INT16_MIN) || (v > INT16_MAX)) return false; value->i16 = (int16_t)v; break;
+        case OPT_TYPE_I32: if ((v < INT32_MIN) || (v > INT32_MAX)) return false; value->i32 = (int32_t)v; break;
+        default:           value->i64 = (int64_t)v; break;
+      };
+      return true;
+    };
+    case OPT_TYPE_U8: case OPT_TYPE_U16: case OPT_TYPE_U32: case OPT_TYPE_U64:
+    {
+      while (isspace((unsigned char)*str)) str++;
+      if (*str == '-') return false;
+      unsigned long long v = strtoull(str, &end, 10);
+      if ((end == str) || (errno != 0) || !_paramsParseEnd(end)) return false;
+      switch (type_value) {
+        case OPT_TYPE_U8:  if (v > UINT8_MAX) return false; value->u8 = (uint8_t)v; break;
+        case OPT_TYPE_U16: if (v > UINT16_MAX) return false; value->u16 = (uint16_t)v; break;
+        case OPT_TYPE_U32: if (v > UINT32_MAX) return false; value->u32 = (uint32_t)v; break;
+        default:           value->u64 = (uint64_t)v; break;
+      };
+      return true;
+    };
+    case OPT_TYPE_FLOAT:
+      value->f = strtof(str, &end);
+      return (end != str) && (errno == 0) && _paramsParseEnd(end);
+    case OPT_TYPE_DOUBLE:
+      value->d = strtod(str, &end);
+      return (end != str) && (errno == 0) && _paramsParseEnd(end);
+    default:
+      return false;
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// -------------------------------------------------- Change handlers ----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+  paramsEntryHandle_t entry;
+  param_change_mode_t mode;
+} paramsNotify_t;
+
+// The identifier of the parameter in events is the address of its variable
+static inline uint32_t _paramsEntryId(paramsEntryHandle_t entry)
+{
+  return (uint32_t)entry->value;
+}
+
+// Post event and call change handler
+static void _paramsCallHandler(paramsEntryHandle_t entry, param_change_mode_t mode)
+{
+  if (entry->meta->type_handler > PARAM_HANDLER_NONE) {
+    uint32_t id = _paramsEntryId(entry);
+    if (id > 0) {
+      int32_t event_id = RE_PARAMS_CHANGED;
+      if (mode == PARAM_NVS_RESTORED) {
+        event_id = RE_PARAMS_RESTORED;
+      } else if (mode == PARAM_SET_INTERNAL) {
+        event_id = RE_PARAMS_INTERNAL;
+      };
+      eventLoopPost(RE_PARAMS_EVENTS, event_id, &id, sizeof(id), portMAX_DELAY);
+    };
+    if (entry->meta->handler) {
+      if (entry->meta->type_handler == PARAM_HANDLER_CALLBACK) {
+        params_callback_t cbf = (params_callback_t)entry->meta->handler;
+        cbf(entry, mode, entry->value);
+      } else {
+        param_handler_t* hdr = (param_handler_t*)entry->meta->handler;
+        hdr->onChange(mode);
+      };
+    };
+  };
+}
+
+#if CONFIG_PARAMS_HANDLER_ASYNC
+
+static void paramsHandlerTaskExec(void *pvParameters)
+{
+  paramsNotify_t notify;
+  while (1) {
+    if (xQueueReceive(paramsHandlerQueue, &notify, portMAX_DELAY) == pdPASS) {
+      _paramsCallHandler(notify.entry, notify.mode);
+    };
+  };
+  vTaskDelete(nullptr);
+}
+
+static bool _paramsHandlerTaskCreate()
+{
+  paramsHandlerQueue = xQueueCreate(CONFIG_PARAMS_HANDLER_QUEUE_SIZE, sizeof(paramsNotify_t));
+  if (paramsHandlerQueue) {
+    if (xTaskCreatePinnedToCore(paramsHandlerTaskExec, "params_handler", CONFIG_PARAMS_HANDLER_TASK_STACK_SIZE, nullptr, 
+        CONFIG_PARAMS_HANDLER_TASK_PRIORITY, &paramsHandlerTask, CONFIG_PARAMS_HANDLER_TASK_CORE) == pdPASS) {
+      return true;
+    };
+    vQueueDelete(paramsHandlerQueue);
+    paramsHandlerQueue = nullptr;
+  };
+  rlog_w(logTAG, "Failed to create task for change handlers, handlers will be called directly");
+  return false;
+}
+
+static void _paramsHandlerTaskDelete()
+{
+  if (paramsHandlerTask) {
+    vTaskDelete(paramsHandlerTask);
+    paramsHandlerTask = nullptr;
+  };
+  if (paramsHandlerQueue) {
+    vQueueDelete(paramsHandlerQueue);
+    paramsHandlerQueue = nullptr;
+  };
+}
+
+#endif // CONFIG_PARAMS_HANDLER_ASYNC
+
+// Notify about the parameter change: directly or through the handler task
+static void _paramsNotify(paramsEntryHandle_t entry, param_change_mode_t mode)
+{
+  #if CONFIG_PARAMS_HANDLER_ASYNC
+    if (paramsHandlerQueue) {
+      if (entry->meta->type_handler > PARAM_HANDLER_NONE) {
+        paramsNotify_t notify = { entry, mode };
+        if (xQueueSend(paramsHandlerQueue, &notify, 0) != pdPASS) {
+          _paramsHandlerDropped++;
+          rlog_w(logTAG, "Handler queue overflow, notification for parameter \"%s\" dropped", entry->key);
+        };
+      };
+      return;
+    };
+  #endif // CONFIG_PARAMS_HANDLER_ASYNC
+  _paramsCallHandler(entry, mode);
+}
+
+uint32_t paramsHandlerDropped()
+{
+  return _paramsHandlerDropped;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- NVS storage ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+static bool _paramsIsStored(paramsEntryHandle_t entry)
+{
+  return ((entry->type_param == OPT_KIND_PARAMETER) 
+       || (entry->type_param == OPT_KIND_PARAMETER_LOCATION) 
+       || (entry->type_param == OPT_KIND_LOCDATA_STORED)
+       || (entry->type_param == OPT_KIND_EXTDATA_STORED)) 
+      && (entry->group) && (entry->group->key);
+}
+
+// Values are written through an already open namespace with the same encoding as reNvs: floating point numbers 
+// as blobs, strings as strings. Only unknown types are written by reNvs, which commits them separately
+static bool _paramsNvsSetValue(nvs_handle_t nvs_handle, paramsEntryHandle_t entry)
+{
+  esp_err_t err = ESP_OK;
+  switch (entry->type_value) {
+    case OPT_TYPE_I8:
+      err = nvs_set_i8(nvs_handle, entry->key, *(int8_t*)entry->value);
+      break;
+    case OPT_TYPE_U8:
+      err = nvs_set_u8(nvs_handle, entry->key, *(uint8_t*)entry->value);
+      break;
+    case OPT_TYPE_I16:
+      err = nvs_set_i16(nvs_handle, entry->key, *(int16_t*)entry->value);
+      break;
+    case OPT_TYPE_U16:
+      err = nvs_set_u16(nvs_handle, entry->key, *(uint16_t*)entry->value);
+      break;
+    case OPT_TYPE_I32:
+      err = nvs_set_i32(nvs_handle, entry->key, *(int32_t*)entry->value);
+      break;
+    case OPT_TYPE_U32:
+      err = nvs_set_u32(nvs_handle, entry->key, *(uint32_t*)entry->value);
+      break;
+    case OPT_TYPE_I64:
+      err = nvs_set_i64(nvs_handle, entry->key, *(int64_t*)entry->value);
+      break;
+    case OPT_TYPE_U64:
+      err = nvs_set_u64(nvs_handle, entry->key, *(uint64_t*)entry->value);
+      break;
+    case OPT_TYPE_FLOAT:
+      err = nvs_set_blob(nvs_handle, entry->key, entry->value, sizeof(float));
+      break;
+    case OPT_TYPE_DOUBLE:
+      err = nvs_set_blob(nvs_handle, entry->key, entry->value, sizeof(double));
+      break;
+    case OPT_TYPE_STRING:
+      err = nvs_set_str(nvs_handle, entry->key, (const char*)entry->value);
+      break;
+    default:
+      return nvsWrite(entry->group->key, entry->key, entry->type_value, entry->value);
+  };
+  if (err != ESP_OK) {
+    rlog_e(logTAG, "Error writing parameter \"%s.%s\" to NVS: %s", entry->group->key, entry->key, esp_err_to_name(err));
+  };
+  return err == ESP_OK;
+}
+
+// Write all changed values of one group (NVS namespace) with a single commit
+static void _paramsNvsFlushGroup(paramsEntryHandle_t first)
+{
+  paramsGroupHandle_t group = first->group;
+  nvs_handle_t nvs_handle;
+  esp_err_t err = nvs_open(group->key, NVS_READWRITE, &nvs_handle);
+  if (err == ESP_OK) {
+    uint16_t count = 0;
+    paramsEntryHandle_t item = first;
+    while (item) {
+      if ((item->dirty) && (item->group == group)) {
+        item->dirty = false;
+        if (_paramsNvsSetValue(nvs_handle, item)) count++;
+      };
+      item = STAILQ_NEXT(item, next);
+    };
+    err = nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    if (err == ESP_OK) {
+      rlog_d(logTAG, "Saved %d parameters of group \"%s\"", count, group->key);
+    } else {
+      rlog_e(logTAG, "Error committing group \"%s\" to NVS: %s", group->key, esp_err_to_name(err));
+    };
+  } else {
+    rlog_e(logTAG, "Error opening NVS namespace \"%s\": %s", group->key, esp_err_to_name(err));
+  };
+}
+
+#if CONFIG_PARAMS_NVS_DELAYED_WRITE
+
+// The list of parameters is append-only, so it can be walked without paramsLock
+static bool _paramsNvsFlush(TickType_t wait)
+{
+  bool ret = true;
+  if (paramsList) {
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      if (item->dirty) {
+        if (xSemaphoreTake(_paramsEntryLock(item), wait) == pdTRUE) {
+          _paramsNvsFlushGroup(item);
+          ENTRY_UNLOCK(item);
+        } else {
+          ret = false;
+        };
+      };
+    };
+  };
+  return ret;
+}
+
+static void paramsNvsTimerCallback(TimerHandle_t timer)
+{
+  // Flash erase and write may take tens of milliseconds, they are performed by the worker task
+  xTaskNotify(paramsWorkerTask, PARAMS_WORK_NVS_FLUSH, eSetBits);
+}
+
+#endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+
+static bool _paramsNvsRestore(paramsEntryHandle_t item)
+{
+  bool ret = false;
+  void* prev_value = clone2value(item->type_value, item->value);
+  if ((item->group) && (item->group->key)) {
+    _paramsValueWriteBegin(item);
+    ret = nvsRead(item->group->key, item->key, item->type_value, item->value);
+    _paramsValueWriteEnd(item);
+  };
+  if (prev_value) {
+    if (!equal2value(item->type_value, prev_value, item->value)) {
+      _paramsNotify(item, PARAM_NVS_RESTORED);
+    };
+    free(prev_value);
+  };
+  return ret;
+}
+
+// Read a scalar value through an already open namespace; returns 0 if the type is not a scalar
+static size_t _paramsNvsGetValue(nvs_handle_t nvs_handle, paramsEntryHandle_t entry, void* buf, esp_err_t* err)
+{
+  switch (entry->type_value) {
+    case OPT_TYPE_I8:
+      *err = nvs_get_i8(nvs_handle, entry->key, (int8_t*)buf);
+      return sizeof(int8_t);
+    case OPT_TYPE_U8:
+      *err = nvs_get_u8(nvs_handle, entry->key, (uint8_t*)buf);
+      return sizeof(uint8_t);
+    case OPT_TYPE_I16:
+      *err = nvs_get_i16(nvs_handle, entry->key, (int16_t*)buf);
+      return sizeof(int16_t);
+    case OPT_TYPE_U16:
+      *err = nvs_get_u16(nvs_handle, entry->key, (uint16_t*)buf);
+      return sizeof(uint16_t);
+    case OPT_TYPE_I32:
+      *err = nvs_get_i32(nvs_handle, entry->key, (int32_t*)buf);
+      return sizeof(int32_t);
+    case OPT_TYPE_U32:
+      *err = nvs_get_u32(nvs_handle, entry->key, (uint32_t*)buf);
+      return sizeof(uint32_t);
+    case OPT_TYPE_I64:
+      *err = nvs_get_i64(nvs_handle, entry->key, (int64_t*)buf);
+      return sizeof(int64_t);
+    case OPT_TYPE_U64:
+      *err = nvs_get_u64(nvs_handle, entry->key, (uint64_t*)buf);
+      return sizeof(uint64_t);
+    case OPT_TYPE_FLOAT:
+    case OPT_TYPE_DOUBLE:
+      {
+        size_t size = _paramsValueSize(entry->type_value);
+        size_t len = size;
+        *err = nvs_get_blob(nvs_handle, entry->key, buf, &len);
+        if ((*err == ESP_OK) && (len != size)) {
+          *err = ESP_ERR_NVS_INVALID_LENGTH;
+        };
+        return size;
+      };
+    default:
+      return 0;
+  };
+}
+
+// Read the value of the parameter through an already open namespace. Returns false if the value is not 
+// found in NVS or cannot be read
+static bool _paramsNvsReadItem(nvs_handle_t nvs_handle, paramsEntryHandle_t item)
+{
+  esp_err_t err = ESP_OK;
+  if (item->type_value == OPT_TYPE_STRING) {
+    char buf[CONFIG_PARAMS_NVS_STRING_BUFFER];
+    size_t len = sizeof(buf);
+    err = nvs_get_str(nvs_handle, item->key, buf, &len);
+    if (err == ESP_OK) {
+      if (strcmp((char*)item->value, buf) != 0) {
+        _paramsValueWriteBegin(item);
+        setNewValue(item->type_value, item->value, buf);
+        _paramsValueWriteEnd(item);
+        _paramsNotify(item, PARAM_NVS_RESTORED);
+      };
+    } else if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+      // The string does not fit into the buffer
+      return _paramsNvsRestore(item);
+    };
+  } else {
+    paramsValue_t buf;
+    size_t size = _paramsNvsGetValue(nvs_handle, item, &buf, &err);
+    if (size == 0) {
+      return _paramsNvsRestore(item);
+    };
+    if ((err == ESP_OK) && (memcmp(item->value, &buf, size) != 0)) {
+      _paramsValueWriteBegin(item);
+      memcpy(item->value, &buf, size);
+      _paramsValueWriteEnd(item);
+      _paramsNotify(item, PARAM_NVS_RESTORED);
+    };
+  };
+  return err == ESP_OK;
+}
+
+// Read all pending values of one group (NVS namespace), opening it only once
+static void _paramsNvsRestoreGroup(paramsEntryHandle_t first)
+{
+  paramsGroupHandle_t group = first->group;
+  nvs_handle_t nvs_handle;
+  // If the namespace does not exist yet, nothing has been saved for this group
+  bool opened = nvs_open(group->key, NVS_READONLY, &nvs_handle) == ESP_OK;
+  uint16_t count = 0;
+  paramsEntryHandle_t item = first;
+  while (item) {
+    if ((item->restore_pending) && (item->group == group)) {
+      item->restore_pending = false;
+      if ((opened) && (item->value)) {
+        _paramsNvsReadItem(nvs_handle, item);
+        count++;
+      };
+    };
+    item = STAILQ_NEXT(item, next);
+  };
+  if (opened) {
+    nvs_close(nvs_handle);
+  };
+  rlog_d(logTAG, "Restored %d parameters of group \"%s\"", count, group->key);
+}
+
+void paramsRestoreAll()
+{
+  #if CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+    if ((paramsLock) && (paramsList)) {
+      OPTIONS_LOCK();
+      paramsEntryHandle_t item;
+      STAILQ_FOREACH(item, paramsList, next) {
+        if (item->restore_pending) {
+          ENTRY_LOCK(item);
+          _paramsNvsRestoreGroup(item);
+          ENTRY_UNLOCK(item);
+        };
+      };
+      OPTIONS_UNLOCK();
+    };
+  #endif // CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+}
+
+static void _paramsNvsStore(paramsEntryHandle_t entry)
+{
+  if (_paramsIsStored(entry)) {
+    #if CONFIG_PARAMS_NVS_DELAYED_WRITE
+      if (paramsNvsTimer) {
+        // Repeated changes of the same parameter are coalesced into one write
+        entry->dirty = true;
+        if (xTimerIsTimerActive(paramsNvsTimer) == pdFALSE) {
+          xTimerStart(paramsNvsTimer, 0);
+        };
+        return;
+      };
+    #endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+    nvsWrite(entry->group->key, entry->key, entry->type_value, entry->value);
+  };
+}
+
+// Write the values of the group marked as dirty (the caller holds the group lock)
+static void _paramsNvsStoreGroup(paramsGroupHandle_t group)
+{
+  #if CONFIG_PARAMS_NVS_DELAYED_WRITE
+    if (paramsNvsTimer) {
+      if (xTimerIsTimerActive(paramsNvsTimer) == pdFALSE) {
+        xTimerStart(paramsNvsTimer, 0);
+      };
+      return;
+    };
+  #endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+  if (paramsList) {
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      if ((item->dirty) && (item->group == group)) {
+        _paramsNvsFlushGroup(item);
+        break;
+      };
+    };
+  };
+}
+
+void paramsFlush()
+{
+  #if CONFIG_PARAMS_NVS_DELAYED_WRITE
+    if (paramsNvsTimer) {
+      xTimerStop(paramsNvsTimer, 0);
+    };
+    _paramsNvsFlush(portMAX_DELAY);
+  #endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Memory pools -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// Pool: a list of memory blocks from which objects are cut off one after another. Objects are never released 
+// individually, only all at once. Parameters, groups and topics are allocated this way to reduce heap fragmentation
+typedef struct paramsPoolBlock_t {
+  paramsPoolBlock_t *next;
+  size_t size;
+  size_t used;
+  char data[] __attribute__((aligned(8)));
+} paramsPoolBlock_t;
+
+typedef struct {
+  paramsPoolBlock_t *blocks;
+  size_t block_size;
+  size_t align;
+} paramsPool_t;
+
+// The pool of parameters and groups is protected by paramsLock, the pool of metadata by paramsMetaLock, 
+// the topic arena by paramsIndexLock
+static paramsPool_t _paramsEntryPool = { nullptr, CONFIG_PARAMS_SLAB_ITEMS * sizeof(paramsEntry_t), 8 };
+static paramsPool_t _paramsMetaPool = { nullptr, CONFIG_PARAMS_SLAB_ITEMS * sizeof(paramsEntryMeta_t), 8 };
+static paramsPool_t _paramsGroupPool = { nullptr, CONFIG_PARAMS_SLAB_ITEMS * sizeof(paramsGroup_t), 8 };
+static paramsPool_t _paramsTopicArena = { nullptr, CONFIG_PARAMS_TOPIC_ARENA_BLOCK, sizeof(void*) };
+static bool _paramsTopicArenaFrozen = false;
+static uint32_t _paramsEntryCount = 0;
+static uint32_t _paramsGroupCount = 0;
+
+static void* _paramsPoolAlloc(paramsPool_t* pool, size_t size)
+{
+  size = (size + pool->align - 1) & ~(pool->align - 1);
+  if ((pool->blocks == nullptr) || (pool->blocks->used + size > pool->blocks->size)) {
+    size_t block_size = size > pool->block_size ? size : pool->block_size;
+    paramsPoolBlock_t* block = (paramsPoolBlock_t*)esp_malloc(sizeof(paramsPoolBlock_t) + block_size);
+    if (block == nullptr) return nullptr;
+    block->size = block_size;
+    block->used = 0;
+    block->next = pool->blocks;
+    pool->blocks = block;
+  };
+  void* ret = pool->blocks->data + pool->blocks->used;
+  pool->blocks->used += size;
+  memset(ret, 0, size);
+  return ret;
+}
+
+// Metadata is also allocated by the setters of limits, which do not hold paramsLock
+static paramsEntryMeta_t* _paramsMetaAlloc()
+{
+  xSemaphoreTake(paramsMetaLock, portMAX_DELAY);
+  paramsEntryMeta_t* meta = (paramsEntryMeta_t*)_paramsPoolAlloc(&_paramsMetaPool, sizeof(paramsEntryMeta_t));
+  xSemaphoreGive(paramsMetaLock);
+  return meta;
+}
+
+static void _paramsPoolFree(paramsPool_t* pool)
+{
+  while (pool->blocks) {
+    paramsPoolBlock_t* block = pool->blocks;
+    pool->blocks = block->next;
+    free(block);
+  };
+}
+
+static size_t _paramsPoolSize(paramsPool_t* pool)
+{
+  size_t ret = 0;
+  paramsPoolBlock_t* block = pool->blocks;
+  while (block) {
+    ret += sizeof(paramsPoolBlock_t) + block->size;
+    block = block->next;
+  };
+  return ret;
+}
+
+// Topic strings are stored in the arena, which is released all together when the topics are reset
+static void* _paramsTopicArenaAlloc(size_t size)
+{
+  void* ret = nullptr;
+  INDEX_LOCK();
+  if (!_paramsTopicArenaFrozen) {
+    ret = _paramsPoolAlloc(&_paramsTopicArena, size);
+  };
+  INDEX_UNLOCK();
+  return ret;
+}
+
+// Copy "prefix/key" or "prefix" (if key is nullptr) to the arena
+static char* _paramsTopicArenaString(const char* prefix, const char* key)
+{
+  size_t len_prefix = strlen(prefix);
+  size_t len_key = key ? strlen(key) + 1 : 0;
+  char* ret = (char*)_paramsTopicArenaAlloc(len_prefix + len_key + 1);
+  if (ret) {
+    memcpy(ret, prefix, len_prefix);
+    if (key) {
+      ret[len_prefix] = '/';
+      memcpy(ret + len_prefix + 1, key, len_key - 1);
+    };
+    ret[len_prefix + len_key] = '\0';
+  };
+  return ret;
+}
+
+// Freezing the arena prevents new topics from being created while the old ones are being reset
+static void _paramsTopicArenaFreeze(bool frozen)
+{
+  INDEX_LOCK();
+  _paramsTopicArenaFrozen = frozen;
+  INDEX_UNLOCK();
+}
+
+// Release all blocks, no entry or group can refer to the arena at this point
+static void _paramsTopicArenaReset()
+{
+  INDEX_LOCK();
+  _paramsPoolFree(&_paramsTopicArena);
+  INDEX_UNLOCK();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Worker task ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+#if PARAMS_WORKER_ENABLED
+
+static void paramsWorkerTaskExec(void *pvParameters)
+{
+  uint32_t work = 0;
+  while (1) {
+    if (xTaskNotifyWait(0, UINT32_MAX, &work, portMAX_DELAY) == pdPASS) {
+      #if CONFIG_PARAMS_NVS_DELAYED_WRITE
+        if (work & PARAMS_WORK_NVS_FLUSH) {
+          _paramsNvsFlush(portMAX_DELAY);
+        };
+      #endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+      #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+        if (work & PARAMS_WORK_PUBLISH) {
+          _paramsPublishPending();
+        };
+      #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+      #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST
+        if (work & PARAMS_WORK_DIGEST) {
+          _paramsDigestSend();
+        };
+      #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST
+    };
+  };
+  vTaskDelete(nullptr);
+}
+
+static bool _paramsWorkerTaskCreate()
+{
+  if (xTaskCreatePinnedToCore(paramsWorkerTaskExec, "params_worker", CONFIG_PARAMS_WORKER_TASK_STACK_SIZE, nullptr, 
+      CONFIG_PARAMS_WORKER_TASK_PRIORITY, &paramsWorkerTask, CONFIG_PARAMS_WORKER_TASK_CORE) == pdPASS) {
+    return true;
+  };
+  paramsWorkerTask = nullptr;
+  rlog_w(logTAG, "Failed to create worker task, background work will be done immediately");
+  return false;
+}
+
+static void _paramsWorkerTaskDelete()
+{
+  if (paramsWorkerTask) {
+    vTaskDelete(paramsWorkerTask);
+    paramsWorkerTask = nullptr;
+  };
+}
+
+#endif // PARAMS_WORKER_ENABLED
+
 // -----------------------------------------------------------------------------------------------------------------------
 // ------------------------------------------------- Common functions ----------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
+// Release everything created by an unsuccessful paramsInit(), so that it can be called again
+static void _paramsInitCleanup()
+{
+  free(paramsGroupIndex);
+  paramsGroupIndex = nullptr;
+  free(paramsKeyIndex);
+  paramsKeyIndex = nullptr;
+  free(paramsTopicIndex);
+  paramsTopicIndex = nullptr;
+  free(paramsList);
+  paramsList = nullptr;
+  free(paramsGroups);
+  paramsGroups = nullptr;
+  SemaphoreHandle_t* locks[] = { &paramsMetaLock, &paramsUpdateLock, &paramsSubscribeLock, &paramsIndexLock, &paramsSysLock, &paramsLock };
+  for (size_t i = 0; i < sizeof(locks) / sizeof(locks[0]); i++) {
+    if (*locks[i]) {
+      vSemaphoreDelete(*locks[i]);
+      *locks[i] = nullptr;
+    };
+  };
+}
+
 bool paramsInit()
 {
   nvsInit();
 
   if (!paramsList) {
     paramsLock = xSemaphoreCreateMutex();
-    if (!paramsLock) {
+    paramsSysLock = xSemaphoreCreateMutex();
+    paramsIndexLock = xSemaphoreCreateMutex();
+    paramsSubscribeLock = xSemaphoreCreateMutex();
+    paramsUpdateLock = xSemaphoreCreateMutex();
+    paramsMetaLock = xSemaphoreCreateMutex();
+    if (!paramsLock || !paramsSysLock || !paramsIndexLock || !paramsSubscribeLock || !paramsUpdateLock || !paramsMetaLock) {
+      _paramsInitCleanup();
       rlog_e(logTAG, "Can't create parameters mutex!");
       return false;
     };
 
+    // paramsList is checked last: while it is nullptr, the manager is not initialized
+    paramsTopicIndex = (paramsEntryHandle_t*)esp_calloc(CONFIG_PARAMS_INDEX_SIZE, sizeof(paramsEntryHandle_t));
+    paramsKeyIndex = (paramsEntryHandle_t*)esp_calloc(CONFIG_PARAMS_INDEX_SIZE, sizeof(paramsEntryHandle_t));
+    paramsGroupIndex = (paramsGroupHandle_t*)esp_calloc(CONFIG_PARAMS_INDEX_SIZE, sizeof(paramsGroupHandle_t));
     paramsGroups = (paramsGroupHeadHandle_t)esp_malloc(sizeof(paramsGroupHead_t));
-    if (paramsGroups) {
-      STAILQ_INIT(paramsGroups);
-    }
-    else {
-      vSemaphoreDelete(paramsLock);
+    paramsList = (paramsEntryHeadHandle_t)esp_malloc(sizeof(paramsEntryHead_t));
+    if (!paramsTopicIndex || !paramsKeyIndex || !paramsGroupIndex || !paramsGroups || !paramsList) {
+      _paramsInitCleanup();
       rlog_e(logTAG, "Parameters manager initialization error!");
       return false;
-    }
+    };
+    STAILQ_INIT(paramsGroups);
+    STAILQ_INIT(paramsList);
+
+    #if CONFIG_PARAMS_HANDLER_ASYNC
+      _paramsHandlerTaskCreate();
+    #endif // CONFIG_PARAMS_HANDLER_ASYNC
+
+    #if PARAMS_WORKER_ENABLED
+      _paramsWorkerTaskCreate();
+    #endif // PARAMS_WORKER_ENABLED
+
+    #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+      if (paramsWorkerTask) {
+        paramsPublishTimer = xTimerCreate("params_pub", pdMS_TO_TICKS(CONFIG_PARAMS_MQTT_PUBLISH_INTERVAL), pdFALSE, nullptr, paramsPublishTimerCallback);
+      };
+      if (!paramsPublishTimer) {
+        rlog_w(logTAG, "Failed to create timer for publishing, values will be published immediately");
+      };
+    #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+
+    #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST
+      _paramsDigestTimerCreate();
+    #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST
+
+    #if CONFIG_PARAMS_NVS_DELAYED_WRITE
+      if (paramsWorkerTask) {
+        paramsNvsTimer = xTimerCreate("params_nvs", pdMS_TO_TICKS(CONFIG_PARAMS_NVS_WRITE_DELAY), pdFALSE, nullptr, paramsNvsTimerCallback);
+      };
+      if (!paramsNvsTimer) {
+        rlog_w(logTAG, "Failed to create timer for delayed saving, parameters will be saved immediately");
+      };
+    #endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+  };
+  
+  #if CONFIG_MQTT_OTA_ENABLE
+  paramsRegisterValueEx(OPT_KIND_OTA, OPT_TYPE_STRING, 
+    PARAM_HANDLER_NONE, nullptr, 
+    nullptr, CONFIG_MQTT_OTA_TOPIC, CONFIG_MQTT_OTA_NAME, 
+    CONFIG_MQTT_OTA_QOS, nullptr);
+  #endif // CONFIG_MQTT_OTA_ENABLE
+
+  #if CONFIG_MQTT_COMMAND_ENABLE
+  paramsRegisterValueEx(OPT_KIND_COMMAND, OPT_TYPE_STRING,
+    PARAM_HANDLER_NONE, nullptr, 
+    nullptr, CONFIG_MQTT_COMMAND_TOPIC, CONFIG_MQTT_COMMAND_NAME, 
+    CONFIG_MQTT_COMMAND_QOS, nullptr);
+  #endif // CONFIG_MQTT_COMMAND_ENABLE
+
+  return true;
+}
+
+void paramsFree()
+{
+  paramsFlush();
+  #if CONFIG_PARAMS_NVS_DELAYED_WRITE
+    if (paramsNvsTimer) {
+      xTimerDelete(paramsNvsTimer, portMAX_DELAY);
+      paramsNvsTimer = nullptr;
+    };
+  #endif // CONFIG_PARAMS_NVS_DELAYED_WRITE
+  #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+    if (paramsPublishTimer) {
+      xTimerDelete(paramsPublishTimer, portMAX_DELAY);
+      paramsPublishTimer = nullptr;
+    };
+    _paramsPublishNext = nullptr;
+  #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+  #if CONFIG_PARAMS_HANDLER_ASYNC
+    _paramsHandlerTaskDelete();
+  #endif // CONFIG_PARAMS_HANDLER_ASYNC
+  #if PARAMS_WORKER_ENABLED
+    _paramsWorkerTaskDelete();
+  #endif // PARAMS_WORKER_ENABLED
+  #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST
+    _paramsDigestTimerDelete();
+  #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED && CONFIG_PARAMS_TELEGRAM_DIGEST
+
+  if (paramsList) {
+    paramsEntryHandle_t itemL, tmpL;
+    STAILQ_FOREACH_SAFE(itemL, paramsList, next, tmpL) {
+      STAILQ_REMOVE(paramsList, itemL, paramsEntry_t, next);
+      if ((itemL->topic_subscribe) && itemL->subscribed) {
+        mqttUnsubscribe(itemL->topic_subscribe);
+      };
+    };
+    free(paramsList);
+  };
+
+  if (paramsGroups) {
+    paramsGroupHandle_t itemG, tmpG;
+    STAILQ_FOREACH_SAFE(itemG, paramsGroups, next, tmpG) {
+      STAILQ_REMOVE(paramsGroups, itemG, paramsGroup_t, next);
+      if (itemG->parent) {
+        if (itemG->key) free(itemG->key);
+        if (itemG->topic) free(itemG->topic);
+        if (itemG->friendly) free(itemG->friendly);
+      };
+      if (itemG->lock) vSemaphoreDelete((SemaphoreHandle_t)itemG->lock);
+    };
+    free(paramsGroups);
+  };
+  _paramsPoolFree(&_paramsEntryPool);
+  _paramsPoolFree(&_paramsMetaPool);
+  _paramsPoolFree(&_paramsGroupPool);
+  _paramsEntryCount = 0;
+  _paramsGroupCount = 0;
+  _paramsTopicArenaReset();
+
+  if (paramsTopicIndex) {
+    free(paramsTopicIndex);
+    paramsTopicIndex = nullptr;
+  };
+  if (paramsKeyIndex) {
+    free(paramsKeyIndex);
+    paramsKeyIndex = nullptr;
+  };
+  if (paramsGroupIndex) {
+    free(paramsGroupIndex);
+    paramsGroupIndex = nullptr;
+  };
+
+  _paramsResubscribeNext = nullptr;
+  vSemaphoreDelete(paramsUpdateLock);
+  vSemaphoreDelete(paramsSubscribeLock);
+  vSemaphoreDelete(paramsIndexLock);
+  vSemaphoreDelete(paramsSysLock);
+  vSemaphoreDelete(paramsLock);
+}
+
+void paramsMemoryStats(paramsMemoryStats_t* stats)
+{
+  if (stats) {
+    memset(stats, 0, sizeof(paramsMemoryStats_t));
+    OPTIONS_LOCK();
+    stats->entries = _paramsEntryCount;
+    stats->groups = _paramsGroupCount;
+    stats->entries_bytes = _paramsPoolSize(&_paramsEntryPool) + _paramsPoolSize(&_paramsMetaPool);
+    stats->groups_bytes = _paramsPoolSize(&_paramsGroupPool);
+    INDEX_LOCK();
+    stats->topics_bytes = _paramsPoolSize(&_paramsTopicArena);
+    INDEX_UNLOCK();
+    OPTIONS_UNLOCK();
+    stats->index_bytes = (2 * sizeof(paramsEntryHandle_t) + sizeof(paramsGroupHandle_t)) * CONFIG_PARAMS_INDEX_SIZE;
+    stats->total_bytes = stats->entries_bytes + stats->groups_bytes + stats->topics_bytes + stats->index_bytes;
+    if (stats->entries > 0) {
+      stats->bytes_per_param = stats->total_bytes / stats->entries;
+    };
+    rlog_d(logTAG, "Parameters: %" PRIu32 ", groups: %" PRIu32 ", memory used: %u bytes (%u bytes per parameter)", 
+      stats->entries, stats->groups, (unsigned)stats->total_bytes, (unsigned)stats->bytes_per_param);
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Topic index ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+#define PARAMS_HASH_INIT 2166136261UL
+
+// FNV-1a, case insensitive for ASCII letters, as strcasecmp in the "C" locale (topics are compared using strcasecmp)
+static uint32_t _paramsHashStr(uint32_t hash, const char* str)
+{
+  if (str) {
+    while (*str) {
+      uint8_t c = (uint8_t)*str++;
+      hash ^= ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c;
+      hash *= 16777619UL;
+    };
+  };
+  return hash;
+}
+
+// paramsIndexLock must be taken
+static void _paramsTopicIndexUnlink(paramsEntryHandle_t entry)
+{
+  paramsEntryHandle_t* link = &paramsTopicIndex[entry->topic_hash % CONFIG_PARAMS_INDEX_SIZE];
+  while (*link) {
+    if (*link == entry) {
+      *link = entry->topic_next;
+      break;
+    };
+    link = &(*link)->topic_next;
+  };
+  entry->topic_next = nullptr;
+}
+
+static void _paramsTopicIndexLink(paramsEntryHandle_t entry, uint32_t hash)
+{
+  if (paramsTopicIndex) {
+    INDEX_LOCK();
+    _paramsTopicIndexUnlink(entry);
+    entry->topic_hash = hash;
+    entry->topic_next = paramsTopicIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    paramsTopicIndex[hash % CONFIG_PARAMS_INDEX_SIZE] = entry;
+    INDEX_UNLOCK();
+  };
+}
+
+static void _paramsTopicIndexRemove(paramsEntryHandle_t entry)
+{
+  if (paramsTopicIndex) {
+    INDEX_LOCK();
+    _paramsTopicIndexUnlink(entry);
+    INDEX_UNLOCK();
+  };
+}
+
+static void _paramsTopicIndexInsert(paramsEntryHandle_t entry)
+{
+  if (entry->topic_subscribe) {
+    _paramsTopicIndexLink(entry, _paramsHashStr(PARAMS_HASH_INIT, entry->topic_subscribe));
+  };
+}
+
+// paramsIndexLock must be taken
+static paramsEntryHandle_t _paramsTopicIndexFind(const char* topic)
+{
+  if (paramsTopicIndex) {
+    uint32_t hash = _paramsHashStr(PARAMS_HASH_INIT, topic);
+    paramsEntryHandle_t item = paramsTopicIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    while (item) {
+      if ((item->topic_hash == hash) && (item->topic_subscribe) && (strcasecmp(item->topic_subscribe, topic) == 0)) {
+        return item;
+      };
+      item = item->topic_next;
+    };
+  };
+  return nullptr;
+}
+
+// Parameters covered by the wildcard subscription do not need their own subscription topic
+static bool _paramsMqttIsWildcard(paramsEntryHandle_t entry)
+{
+  #if CONFIG_MQTT_PARAMS_WILDCARD
+    return (entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE);
+  #else
+    return false;
+  #endif // CONFIG_MQTT_PARAMS_WILDCARD
+}
+
+#if CONFIG_MQTT_PARAMS_WILDCARD
+
+// Route is the part of the topic after the wildcard prefix: "group_topic/key" or "key"
+static uint32_t _paramsRouteHash(paramsEntryHandle_t entry)
+{
+  uint32_t hash = PARAMS_HASH_INIT;
+  if ((entry->group) && (entry->group->topic)) {
+    hash = _paramsHashStr(hash, entry->group->topic);
+    hash = _paramsHashStr(hash, "/");
+  };
+  return _paramsHashStr(hash, entry->key);
+}
+
+static bool _paramsRouteEqual(paramsEntryHandle_t entry, const char* route)
+{
+  if ((entry->group) && (entry->group->topic)) {
+    size_t len = strlen(entry->group->topic);
+    if ((strncasecmp(route, entry->group->topic, len) != 0) || (route[len] != '/')) {
+      return false;
+    };
+    route += len + 1;
+  };
+  return strcasecmp(route, entry->key) == 0;
+}
+
+// Wildcard parameters are indexed by route once at registration, it does not depend on the broker
+static void _paramsTopicIndexInsertRoute(paramsEntryHandle_t entry)
+{
+  if (entry->key) {
+    _paramsTopicIndexLink(entry, _paramsRouteHash(entry));
+  };
+}
+
+// paramsIndexLock must be taken
+static paramsEntryHandle_t _paramsTopicIndexFindRoute(const char* route)
+{
+  if (paramsTopicIndex) {
+    uint32_t hash = _paramsHashStr(PARAMS_HASH_INIT, route);
+    paramsEntryHandle_t item = paramsTopicIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    while (item) {
+      if ((item->topic_hash == hash) && _paramsMqttIsWildcard(item) && _paramsRouteEqual(item, route)) {
+        return item;
+      };
+      item = item->topic_next;
+    };
+  };
+  return nullptr;
+}
+
+#endif // CONFIG_MQTT_PARAMS_WILDCARD
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------- Key index -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+static bool _paramsKeyEqual(const char* key1, const char* key2)
+{
+  if ((key1) && (key2)) {
+    return strcasecmp(key1, key2) == 0;
+  };
+  return key1 == key2;
+}
+
+// Full key of the group is "parent_key.name_key", compare it in parts without creating a string
+static bool _paramsGroupKeyEqual(paramsGroupHandle_t group, paramsGroupHandle_t parent, const char* name_key)
+{
+  if ((parent) && (parent->key) && (group->key) && (name_key)) {
+    size_t len = strlen(parent->key);
+    return (strncasecmp(group->key, parent->key, len) == 0) 
+        && (group->key[len] == '.') 
+        && (strcasecmp(group->key + len + 1, name_key) == 0);
+  };
+  return _paramsKeyEqual(group->key, name_key);
+}
 
-    paramsList = (paramsEntryHeadHandle_t)esp_malloc(sizeof(paramsEntryHead_t));
-    if (paramsList) {
-      STAILQ_INIT(paramsList);
-    }
-    else {
-      vSemaphoreDelete(paramsLock);
-      rlog_e(logTAG, "Parameters manager initialization error!");
-      return false;
-    };
+static uint32_t _paramsGroupHash(paramsGroupHandle_t parent, const char* name_key)
+{
+  uint32_t hash = PARAMS_HASH_INIT;
+  if ((parent) && (parent->key)) {
+    hash = _paramsHashStr(hash, parent->key);
+    hash = _paramsHashStr(hash, ".");
   };
-  
-  #if CONFIG_MQTT_OTA_ENABLE
-  paramsRegisterValueEx(OPT_KIND_OTA, OPT_TYPE_STRING, 
-    PARAM_HANDLER_NONE, nullptr, 
-    nullptr, CONFIG_MQTT_OTA_TOPIC, CONFIG_MQTT_OTA_NAME, 
-    CONFIG_MQTT_OTA_QOS, nullptr);
-  #endif // CONFIG_MQTT_OTA_ENABLE
+  return _paramsHashStr(hash, name_key);
+}
 
-  #if CONFIG_MQTT_COMMAND_ENABLE
-  paramsRegisterValueEx(OPT_KIND_COMMAND, OPT_TYPE_STRING,
-    PARAM_HANDLER_NONE, nullptr, 
-    nullptr, CONFIG_MQTT_COMMAND_TOPIC, CONFIG_MQTT_COMMAND_NAME, 
-    CONFIG_MQTT_COMMAND_QOS, nullptr);
-  #endif // CONFIG_MQTT_COMMAND_ENABLE
+static uint32_t _paramsEntryHash(const char* group_key, const char* key)
+{
+  uint32_t hash = _paramsHashStr(PARAMS_HASH_INIT, group_key);
+  hash = _paramsHashStr(hash, ".");
+  return _paramsHashStr(hash, key);
+}
 
-  return true;
+static void _paramsGroupIndexInsert(paramsGroupHandle_t group)
+{
+  if (paramsGroupIndex) {
+    group->key_hash = _paramsHashStr(PARAMS_HASH_INIT, group->key);
+    uint32_t bucket = group->key_hash % CONFIG_PARAMS_INDEX_SIZE;
+    group->key_next = paramsGroupIndex[bucket];
+    paramsGroupIndex[bucket] = group;
+  };
 }
 
-void paramsFree()
+static void _paramsKeyIndexInsert(paramsEntryHandle_t entry)
 {
-  if (paramsList) {
-    paramsEntryHandle_t itemL, tmpL;
-    STAILQ_FOREACH_SAFE(itemL, paramsList, next, tmpL) {
-      STAILQ_REMOVE(paramsList, itemL, paramsEntry_t, next);
-      if ((itemL->topic_subscribe) && itemL->subscribed) {
-        mqttUnsubscribe(itemL->topic_subscribe);
-        free(itemL->topic_subscribe);
+  if (paramsKeyIndex) {
+    entry->key_hash = _paramsEntryHash(entry->group ? entry->group->key : nullptr, entry->key);
+    uint32_t bucket = entry->key_hash % CONFIG_PARAMS_INDEX_SIZE;
+    entry->key_next = paramsKeyIndex[bucket];
+    paramsKeyIndex[bucket] = entry;
+  };
+}
+
+static paramsGroupHandle_t _paramsGroupIndexFind(paramsGroupHandle_t parent, const char* name_key)
+{
+  if (paramsGroupIndex) {
+    uint32_t hash = _paramsGroupHash(parent, name_key);
+    paramsGroupHandle_t item = paramsGroupIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    while (item) {
+      if ((item->key_hash == hash) && (item->parent == parent) && _paramsGroupKeyEqual(item, parent, name_key)) {
+        return item;
       };
-      #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-      if (itemL->topic_publish) {
-        free(itemL->topic_publish);
+      item = item->key_next;
+    };
+  };
+  return nullptr;
+}
+
+static paramsEntryHandle_t _paramsKeyIndexFind(paramsGroupHandle_t group, const char* key)
+{
+  if (paramsKeyIndex) {
+    uint32_t hash = _paramsEntryHash(group ? group->key : nullptr, key);
+    paramsEntryHandle_t item = paramsKeyIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    while (item) {
+      if ((item->key_hash == hash) && (item->group == group) && _paramsKeyEqual(item->key, key)) {
+        return item;
       };
-      #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-      free(itemL);
+      item = item->key_next;
     };
-    free(paramsList);
   };
+  return nullptr;
+}
 
-  if (paramsGroups) {
-    paramsGroupHandle_t itemG, tmpG;
-    STAILQ_FOREACH_SAFE(itemG, paramsGroups, next, tmpG) {
-      STAILQ_REMOVE(paramsGroups, itemG, paramsGroup_t, next);
-      if (itemG->parent) {
-        if (itemG->key) free(itemG->key);
-        if (itemG->topic) free(itemG->topic);
-        if (itemG->friendly) free(itemG->friendly);
+paramsGroupHandle_t paramsFindGroup(const char* group_key)
+{
+  paramsGroupHandle_t ret = nullptr;
+  if (paramsGroupIndex) {
+    OPTIONS_LOCK();
+    uint32_t hash = _paramsHashStr(PARAMS_HASH_INIT, group_key);
+    paramsGroupHandle_t item = paramsGroupIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    while (item) {
+      if ((item->key_hash == hash) && _paramsKeyEqual(item->key, group_key)) {
+        ret = item;
+        break;
       };
-      free(itemG);
+      item = item->key_next;
     };
-    free(paramsGroups);
+    OPTIONS_UNLOCK();
   };
+  return ret;
+}
 
-  vSemaphoreDelete(paramsLock);
+paramsEntryHandle_t paramsFind(const char* group_key, const char* key)
+{
+  paramsEntryHandle_t ret = nullptr;
+  if (paramsKeyIndex) {
+    OPTIONS_LOCK();
+    uint32_t hash = _paramsEntryHash(group_key, key);
+    paramsEntryHandle_t item = paramsKeyIndex[hash % CONFIG_PARAMS_INDEX_SIZE];
+    while (item) {
+      if ((item->key_hash == hash) && _paramsKeyEqual(item->key, key)
+       && _paramsKeyEqual(item->group ? item->group->key : nullptr, group_key)) {
+        ret = item;
+        break;
+      };
+      item = item->key_next;
+    };
+    OPTIONS_UNLOCK();
+  };
+  return ret;
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
 // ---------------------------------------------------- MQTT topics ------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
+typedef enum {
+  PARAMS_TOPIC_CONFIG = 0,  // %LOCATION% / %DEVICE% / CONFIG / ...
+  PARAMS_TOPIC_CONFIRM,     // %LOCATION% / %DEVICE% / CONFIRM / ...
+  PARAMS_TOPIC_LOCATION,    // %LOCATION% / CONFIG / ...
+  PARAMS_TOPIC_LOCDATA,     // %LOCAL% / ... or %LOCAL% / CONFIG_MQTT_ROOT_LOCDATA_TOPIC / ...
+  PARAMS_TOPIC_EXTDATA,     // ... 
+  PARAMS_TOPIC_SIGNAL,      // %LOCATION% / %DEVICE% / ...
+  PARAMS_TOPIC_SYSTEM,      // %LOCATION% / %DEVICE% / SYSTEM / ...
+  PARAMS_TOPIC_MAX
+} params_topic_kind_t;
+
+// Generate topic "%ROOT% / name" in the heap
+static char* _paramsTopicGenerate(params_topic_kind_t kind, const char* name)
+{
+  switch (kind) {
+    case PARAMS_TOPIC_CONFIG:
+      return mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, name, nullptr);
+    case PARAMS_TOPIC_CONFIRM:
+      return mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_CONFIRM_TOPIC, name, nullptr);
+    case PARAMS_TOPIC_LOCATION:
+      return mqttGetTopicLocation(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, name, nullptr);
+    case PARAMS_TOPIC_LOCDATA:
+      #ifdef CONFIG_MQTT_ROOT_LOCDATA_TOPIC
+        return mqttGetTopicSpecial(_paramsMqttPrimary, CONFIG_MQTT_ROOT_LOCDATA_LOCAL, CONFIG_MQTT_ROOT_LOCDATA_TOPIC, name, nullptr);
+      #else
+        return mqttGetTopicLocation(_paramsMqttPrimary, CONFIG_MQTT_ROOT_LOCDATA_LOCAL, name, nullptr, nullptr);
+      #endif // CONFIG_MQTT_ROOT_LOCDATA_TOPIC
+    case PARAMS_TOPIC_EXTDATA:
+      return malloc_string(name);
+    case PARAMS_TOPIC_SIGNAL:
+      return mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, name, nullptr, nullptr);
+    case PARAMS_TOPIC_SYSTEM:
+      return mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_SYSTEM_LOCAL, CONFIG_MQTT_ROOT_SYSTEM_TOPIC, name, nullptr);
+    default:
+      return nullptr;
+  };
+}
+
+// The prefix of the group is generated only once and cached in the group (the caller holds the group lock)
+static char* _paramsTopicGroupPrefix(paramsGroupHandle_t group, params_topic_kind_t kind)
+{
+  if (group->topic_prefix == nullptr) {
+    group->topic_prefix = (char**)_paramsTopicArenaAlloc(PARAMS_TOPIC_MAX * sizeof(char*));
+    if (group->topic_prefix) {
+      memset(group->topic_prefix, 0, PARAMS_TOPIC_MAX * sizeof(char*));
+    };
+  };
+  if (group->topic_prefix) {
+    if (group->topic_prefix[kind] == nullptr) {
+      char* prefix = _paramsTopicGenerate(kind, group->topic);
+      if (prefix) {
+        group->topic_prefix[kind] = _paramsTopicArenaString(prefix, nullptr);
+        free(prefix);
+      };
+    };
+    return group->topic_prefix[kind];
+  };
+  return nullptr;
+}
+
+// Create the topic of the parameter in the arena, topics of parameters without a group are generated completely
+static char* _paramsTopicCreate(paramsEntryHandle_t entry, params_topic_kind_t kind)
+{
+  char* ret = nullptr;
+  paramsGroupHandle_t group = entry->group;
+  if ((group) && (group->topic) && (kind != PARAMS_TOPIC_SYSTEM)) {
+    char* prefix = _paramsTopicGroupPrefix(group, kind);
+    if (prefix) {
+      ret = _paramsTopicArenaString(prefix, entry->key);
+    };
+  } else {
+    char* topic = _paramsTopicGenerate(kind, entry->key);
+    if (topic) {
+      ret = _paramsTopicArenaString(topic, nullptr);
+      free(topic);
+    };
+  };
+  return ret;
+}
+
 void paramsMqttTopicsFreeEntry(paramsEntryHandle_t entry)
 {
   if ((entry->key) && ((entry->topic_subscribe) || (entry->topic_publish))) {
@@ -129,168 +1517,260 @@ void paramsMqttTopicsFreeEntry(paramsEntryHandle_t entry)
     };
   };
 
+  // The memory of the topics is returned to the heap when the arena is reset
   if (entry->topic_subscribe) {
-    free(entry->topic_subscribe);
+    _paramsTopicIndexRemove(entry);
     entry->topic_subscribe = nullptr;
+    _paramsTopicsComplete = false;
   };
-
-  if (entry->topic_publish) {
-    free(entry->topic_publish);
-    entry->topic_publish = nullptr;
-  };
+  entry->topic_publish = nullptr;
 }
 
 void paramsMqttTopicsCreateEntry(paramsEntryHandle_t entry)
 {
   if (entry->key) {
     // Parameters always start with the prefix "config", but some parameter groups can be local
-    // %LOCATION% / %DEVICE% / CONFI[G|RM] / ...
     if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
-      if ((entry->group) && (entry->group->topic)) {
-        entry->topic_subscribe = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, entry->group->topic, entry->key);
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for parameter \"%s.%s\": [ %s ]", entry->group->key, entry->key, entry->topic_subscribe);
-        };
-      } else {
-        entry->topic_subscribe = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, entry->key, nullptr);
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for parameter \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
+      // Incoming messages for these parameters are routed by the wildcard topic suffix
+      if (!_paramsMqttIsWildcard(entry)) {
+        entry->topic_subscribe = _paramsTopicCreate(entry, PARAMS_TOPIC_CONFIG);
+        if (!entry->topic_subscribe) {
+          rlog_e(logTAG, "Failed to generate subscription topic!");
         };
       };
-      if (!entry->topic_subscribe) {
-        rlog_e(logTAG, "Failed to generate subscription topic!");
-      };
       // Confirmation topic: only for parameters, data and commands do not have confirmation topics
       #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-        // Parameters always start with the prefix "confirm", but some parameter groups can be local
-        if ((entry->group) && (entry->group->topic)) {
-          entry->topic_publish = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_CONFIRM_TOPIC, entry->group->topic, entry->key);
-          if (entry->topic_publish) {
-            rlog_d(logTAG, "Generated confirmation topic for parameter \"%s.%s\": [ %s ]", entry->group->key, entry->key, entry->topic_publish);
-          };
+        entry->topic_publish = _paramsTopicCreate(entry, PARAMS_TOPIC_CONFIRM);
+        if (entry->topic_publish) {
+          rlog_d(logTAG, "Generated confirmation topic for parameter \"%s\": [ %s ]", entry->key, entry->topic_publish);
         } else {
-          entry->topic_publish = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_CONFIRM_TOPIC, entry->key, nullptr);
-          if (entry->topic_publish) {
-            rlog_d(logTAG, "Generated confirmation topic for parameter \"%s\": [ %s ]", entry->key, entry->topic_publish);
-          };
-        };
-        if (!entry->topic_publish) {
           rlog_e(logTAG, "Failed to generate confirmation topic!");
         };
       #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-    } 
-
-    // Parameters related to all devices in a given location do not contain the device name
-    // %LOCATION% / CONFIG / ...
-    else if (entry->type_param == OPT_KIND_PARAMETER_LOCATION) {
-      if ((entry->group) && (entry->group->topic)) {
-        entry->topic_subscribe = mqttGetTopicLocation(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, entry->group->topic, entry->key);
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for parameter \"%s.%s\": [ %s ]", entry->group->key, entry->key, entry->topic_subscribe);
-        };
-      } else {
-        entry->topic_subscribe = mqttGetTopicLocation(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, entry->key, nullptr);
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for parameter \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
-        };
-      };
-      if (!entry->topic_subscribe) {
-        rlog_e(logTAG, "Failed to generate subscription topic!");
+    } else {
+      params_topic_kind_t kind;
+      switch (entry->type_param) {
+        // Parameters related to all devices in a given location do not contain the device name
+        case OPT_KIND_PARAMETER_LOCATION: kind = PARAMS_TOPIC_LOCATION; break;
+        // Local data starting with the special prefix %LOCAL%
+        case OPT_KIND_LOCDATA_ONLINE: 
+        case OPT_KIND_LOCDATA_STORED: kind = PARAMS_TOPIC_LOCDATA; break;
+        // External data. Topic is always fixed
+        case OPT_KIND_EXTDATA_ONLINE: 
+        case OPT_KIND_EXTDATA_STORED: kind = PARAMS_TOPIC_EXTDATA; break;
+        // Signals without confirmations
+        case OPT_KIND_SIGNAL: 
+        case OPT_KIND_SIGNAL_AUTOCLR: kind = PARAMS_TOPIC_SIGNAL; break;
+        // Commands have no groups, always start with prefix "system"
+        default: kind = PARAMS_TOPIC_SYSTEM; break;
       };
-    }
-
-    // Local data starting with the special prefix %LOCAL%
-    // %LOCAL% / ... or %LOCAL% / CONFIG_MQTT_ROOT_LOCDATA_TOPIC / ...
-    else if ((entry->type_param == OPT_KIND_LOCDATA_ONLINE) || (entry->type_param == OPT_KIND_LOCDATA_STORED)) {
       entry->topic_publish = nullptr;
-      if ((entry->group) && (entry->group->topic)) {
-        #ifdef CONFIG_MQTT_ROOT_LOCDATA_TOPIC
-          entry->topic_subscribe = mqttGetTopicSpecial(_paramsMqttPrimary, CONFIG_MQTT_ROOT_LOCDATA_LOCAL, CONFIG_MQTT_ROOT_LOCDATA_TOPIC, entry->group->topic, entry->key);
-        #else
-          entry->topic_subscribe = mqttGetTopicLocation(_paramsMqttPrimary, CONFIG_MQTT_ROOT_LOCDATA_LOCAL, entry->group->topic, entry->key, nullptr);
-        #endif // CONFIG_MQTT_ROOT_LOCDATA_TOPIC
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for data \"%s.%s\": [ %s ]", entry->group->key, entry->key, entry->topic_subscribe);
-        };
-      } else {
-        #ifdef CONFIG_MQTT_ROOT_LOCDATA_TOPIC
-          entry->topic_subscribe = mqttGetTopicSpecial(_paramsMqttPrimary, CONFIG_MQTT_ROOT_LOCDATA_LOCAL, CONFIG_MQTT_ROOT_LOCDATA_TOPIC, entry->key, nullptr);
-        #else
-          entry->topic_subscribe = mqttGetTopicLocation(_paramsMqttPrimary, CONFIG_MQTT_ROOT_LOCDATA_LOCAL, entry->key, nullptr, nullptr);
-        #endif // CONFIG_MQTT_ROOT_LOCDATA_TOPIC
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for data \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
-        };
-      };
+      entry->topic_subscribe = _paramsTopicCreate(entry, kind);
       if (!entry->topic_subscribe) {
         rlog_e(logTAG, "Failed to generate subscription topic!");
       };
-    } 
+    };
 
-    // External data. Topic is always fixed
-    else if ((entry->type_param == OPT_KIND_EXTDATA_ONLINE) || (entry->type_param == OPT_KIND_EXTDATA_STORED)) {
-      entry->topic_publish = nullptr;
-      if ((entry->group) && (entry->group->topic)) {
-        entry->topic_subscribe = mqttGetSubTopic(entry->group->topic, entry->key);
-      } else {
-        entry->topic_subscribe = malloc_string(entry->key);
-      };
-      if (entry->topic_subscribe) {
-        rlog_d(logTAG, "Generated subscription topic for data \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
+    if (entry->topic_subscribe) {
+      if ((entry->group) && (entry->group->key)) {
+        rlog_d(logTAG, "Generated subscription topic for parameter \"%s.%s\": [ %s ]", entry->group->key, entry->key, entry->topic_subscribe);
       } else {
-        rlog_e(logTAG, "Failed to generate subscription topic!");
+        rlog_d(logTAG, "Generated subscription topic for parameter \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
       };
-    }
+    };
 
-    // Signals. Topic is // %LOCATION% / %DEVICE% / ... without confirmations
-    else if ((entry->type_param == OPT_KIND_SIGNAL) || (entry->type_param == OPT_KIND_SIGNAL_AUTOCLR)) {
-      if ((entry->group) && (entry->group->topic)) {
-        entry->topic_subscribe = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, entry->group->topic, entry->key, nullptr);
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for parameter \"%s.%s\": [ %s ]", entry->group->key, entry->key, entry->topic_subscribe);
-        };
-      } else {
-        entry->topic_subscribe = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, entry->key, nullptr, nullptr);
-        if (entry->topic_subscribe) {
-          rlog_d(logTAG, "Generated subscription topic for parameter \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
-        };
-      };
-      if (!entry->topic_subscribe) {
-        rlog_e(logTAG, "Failed to generate subscription topic!");
-      };
-    }
+    // Add topic to the index for incoming messages
+    _paramsTopicIndexInsert(entry);
+  };
+}
 
-    // Commands have no groups, always start with prefix "system"
-    else {
-      entry->topic_publish = nullptr;
-      entry->topic_subscribe = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_SYSTEM_LOCAL, CONFIG_MQTT_ROOT_SYSTEM_TOPIC, entry->key, nullptr);
-      if (entry->topic_subscribe) {
-        rlog_d(logTAG, "Generated subscription topic for system command \"%s\": [ %s ]", entry->key, entry->topic_subscribe);
+#if CONFIG_PARAMS_MQTT_BULK
+
+// Topics for bulk change of the group parameters (the caller holds the group lock)
+static void _paramsMqttTopicsCreateGroup(paramsGroupHandle_t group)
+{
+  if ((group->key) && (group->topic) && (group->topic_bulk == nullptr)) {
+    char* prefix = _paramsTopicGroupPrefix(group, PARAMS_TOPIC_CONFIG);
+    group->topic_bulk = prefix ? _paramsTopicArenaString(prefix, CONFIG_PARAMS_MQTT_BULK_KEY) : nullptr;
+    prefix = _paramsTopicGroupPrefix(group, PARAMS_TOPIC_CONFIRM);
+    group->topic_bulk_confirm = prefix ? _paramsTopicArenaString(prefix, CONFIG_PARAMS_MQTT_BULK_KEY) : nullptr;
+    if (group->topic_bulk) {
+      rlog_d(logTAG, "Generated bulk topic for group \"%s\": [ %s ]", group->key, group->topic_bulk);
+    } else {
+      rlog_e(logTAG, "Failed to generate bulk topic for group \"%s\"!", group->key);
+    };
+  };
+}
+
+static void _paramsMqttTopicsCreateGroups()
+{
+  if (paramsGroups) {
+    paramsGroupHandle_t group;
+    STAILQ_FOREACH(group, paramsGroups, next) {
+      GROUP_LOCK(group);
+      _paramsMqttTopicsCreateGroup(group);
+      GROUP_UNLOCK(group);
+    };
+  };
+}
+
+#endif // CONFIG_PARAMS_MQTT_BULK
+
+void _paramsMqttTopicsCreateMissing()
+{
+  if (paramsList) {
+    bool _complete = true;
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      if ((item->key) && (item->topic_subscribe == nullptr) && !_paramsMqttIsWildcard(item)) {
+        uint8_t tryCnt = 0;
+        ENTRY_LOCK(item);
+        do {
+          tryCnt++;
+          paramsMqttTopicsCreateEntry(item);
+          if (item->topic_subscribe == nullptr) {
+            ENTRY_UNLOCK(item);
+            vTaskDelay(10);
+            ENTRY_LOCK(item);
+          };
+        } while ((item->topic_subscribe == nullptr) && (tryCnt < 255));
+        _complete = _complete && (item->topic_subscribe != nullptr);
+        ENTRY_UNLOCK(item);
       };
     };
+    #if CONFIG_PARAMS_MQTT_BULK
+      _paramsMqttTopicsCreateGroups();
+    #endif // CONFIG_PARAMS_MQTT_BULK
+    _paramsTopicsComplete = _complete;
+  };
+}
+
+// Identity of the device in the topics (location and device name): the topics are kept between connections 
+// and are regenerated only if the role of the broker or the identity has changed
+static uint32_t _paramsMqttTopicsIdentity(bool primary)
+{
+  uint32_t hash = PARAMS_HASH_INIT;
+  char* topic = mqttGetTopicDevice(primary, false, CONFIG_MQTT_ROOT_PARAMS_TOPIC, nullptr, nullptr);
+  if (topic) {
+    hash = _paramsHashStr(hash, topic);
+    free(topic);
+  };
+  topic = mqttGetTopicDevice(primary, true, CONFIG_MQTT_ROOT_PARAMS_TOPIC, nullptr, nullptr);
+  if (topic) {
+    hash = _paramsHashStr(hash, topic);
+    free(topic);
+  };
+  return hash;
+}
+
+// Free all topics and switch to another broker role. The caller holds paramsLock
+static void _paramsMqttTopicsReset(bool primary, uint32_t identity)
+{
+  rlog_i(logTAG, "Resetting parameter topics...");
+
+  // New topics cannot be created until the arena is released
+  _paramsTopicArenaFreeze(true);
+  if (paramsList) {
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      ENTRY_LOCK(item);
+      paramsMqttTopicsFreeEntry(item);
+      ENTRY_UNLOCK(item);
+    };
+  };
+  if (paramsGroups) {
+    paramsGroupHandle_t group;
+    STAILQ_FOREACH(group, paramsGroups, next) {
+      GROUP_LOCK(group);
+      group->topic_prefix = nullptr;
+      group->topic_bulk = nullptr;
+      group->topic_bulk_confirm = nullptr;
+      group->bulk_subscribed = false;
+      GROUP_UNLOCK(group);
+    };
+  };
+  _paramsMqttPrimary = primary;
+  _paramsMqttIdentity = identity;
+  _paramsTopicArenaReset();
+  _paramsTopicArenaFreeze(false);
+}
+
+static bool _paramsMqttTopicsReady(paramsEntryHandle_t entry)
+{
+  if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
+    #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
+      if (!entry->topic_publish) return false;
+    #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
+    return (entry->topic_subscribe) || _paramsMqttIsWildcard(entry);
   };
+  return entry->topic_subscribe != nullptr;
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
 // ------------------------------------------------ MQTT internal funcions -----------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
+#if CONFIG_PARAMS_MQTT_BINARY
+
+static params_publish_binary_t _paramsPublishBinary = nullptr;
+
+void paramsMqttSetPublishBinary(params_publish_binary_t publish)
+{
+  _paramsPublishBinary = publish;
+}
+
+static bool _paramsMqttIsBinary(paramsEntryHandle_t entry)
+{
+  return (_paramsPublishBinary) && _paramsIsBinary(entry);
+}
+
+static bool _paramsMqttPublishBinary(paramsEntryHandle_t entry, const char* topic, bool retained)
+{
+  uint8_t data[PARAMS_BINARY_SIZE_MAX];
+  size_t len = _paramsValueEncode(entry, data);
+  return _paramsPublishBinary(topic, data, len, entry->meta->qos, retained);
+}
+
+#endif // CONFIG_PARAMS_MQTT_BINARY
+
+// Text of the current value for publishing, binary parameters are published without conversion (nullptr)
+static char* _paramsMqttValueText(paramsEntryHandle_t entry, paramsValueText_t* text)
+{
+  #if CONFIG_PARAMS_MQTT_BINARY
+    if (_paramsMqttIsBinary(entry)) {
+      text->heap = nullptr;
+      return nullptr;
+    };
+  #endif // CONFIG_PARAMS_MQTT_BINARY
+  return _paramsValueFormat(entry, text);
+}
+
 #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
 
-void _paramsMqttConfirmEntry(paramsEntryHandle_t entry)
+void _paramsMqttConfirmEntry(paramsEntryHandle_t entry, char* value)
 {
   // Parameters only
   if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
-    if (entry->value) {
-      if ((!entry->topic_subscribe) || (!entry->topic_publish)) {
+    #if CONFIG_PARAMS_MQTT_BINARY
+      bool binary = _paramsMqttIsBinary(entry);
+    #else
+      bool binary = false;
+    #endif // CONFIG_PARAMS_MQTT_BINARY
+    if ((value) || (binary)) {
+      if ((!entry->topic_publish) || (!entry->topic_subscribe && !_paramsMqttIsWildcard(entry))) {
         paramsMqttTopicsFreeEntry(entry);
         paramsMqttTopicsCreateEntry(entry);
       };
       if (entry->topic_publish) {
-        mqttPublish(entry->topic_publish, 
-          value2string(entry->type_value, entry->value), 
-          entry->qos, CONFIG_MQTT_CONFIRM_RETAINED, 
-          false, true);
+        #if CONFIG_PARAMS_MQTT_BINARY
+          if (binary) {
+            _paramsMqttPublishBinary(entry, entry->topic_publish, CONFIG_MQTT_CONFIRM_RETAINED);
+            return;
+          };
+        #endif // CONFIG_PARAMS_MQTT_BINARY
+        mqttPublish(entry->topic_publish, value, 
+          entry->meta->qos, CONFIG_MQTT_CONFIRM_RETAINED, 
+          false, false);
       };
     } else {
       rlog_w(logTAG, "Call publication parameter of undetermined value!");
@@ -301,20 +1781,52 @@ void _paramsMqttConfirmEntry(paramsEntryHandle_t entry)
 void paramsMqttConfirmEntry(paramsEntryHandle_t entry)
 {
   if (mqttIsConnected()) {
-    _paramsMqttConfirmEntry(entry);
+    paramsValueText_t text;
+    _paramsMqttConfirmEntry(entry, _paramsMqttValueText(entry, &text));
+    _paramsValueTextFree(&text);
   }
 }
 
 #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
 
-void _paramsMqttPublishEntry(paramsEntryHandle_t entry)
+void _paramsMqttPublishEntry(paramsEntryHandle_t entry, char* value)
 {
   // Parameters
   if ((entry->type_param == OPT_KIND_PARAMETER) 
    || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
    || (entry->type_param == OPT_KIND_PARAMETER_LOCATION)) 
   {
-    if (entry->value) {
+    #if CONFIG_PARAMS_MQTT_BINARY
+      bool binary = _paramsMqttIsBinary(entry);
+    #else
+      bool binary = false;
+    #endif // CONFIG_PARAMS_MQTT_BINARY
+    if ((value) || (binary)) {
+      #if CONFIG_MQTT_PARAMS_WILDCARD
+        if (_paramsMqttIsWildcard(entry)) {
+          // The subscription topic is not stored for wildcard parameters, so generate a temporary one
+          char* topic = nullptr;
+          if ((entry->group) && (entry->group->topic)) {
+            topic = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, entry->group->topic, entry->key);
+          } else {
+            topic = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, entry->key, nullptr);
+          };
+          if (topic) {
+            entry->locked = true;
+            #if CONFIG_PARAMS_MQTT_BINARY
+              if (binary) {
+                _paramsMqttPublishBinary(entry, topic, CONFIG_MQTT_PARAMS_RETAINED);
+                free(topic);
+                return;
+              };
+            #endif // CONFIG_PARAMS_MQTT_BINARY
+            mqttPublish(topic, value, 
+              entry->meta->qos, CONFIG_MQTT_PARAMS_RETAINED, 
+              true, false);
+          };
+          return;
+        };
+      #endif // CONFIG_MQTT_PARAMS_WILDCARD
       if (!entry->topic_subscribe) {
         paramsMqttTopicsFreeEntry(entry);
         paramsMqttTopicsCreateEntry(entry);
@@ -322,11 +1834,16 @@ void _paramsMqttPublishEntry(paramsEntryHandle_t entry)
       if (entry->topic_subscribe) {
         // mqttUnsubscribe(entry->topic_subscribe);
         entry->locked = true;
-        mqttPublish(entry->topic_subscribe, 
-          value2string(entry->type_value, entry->value), 
-          entry->qos, CONFIG_MQTT_PARAMS_RETAINED, 
-          false, true);
-        // entry->subscribed = mqttSubscribe(entry->topic_subscribe, entry->qos);
+        #if CONFIG_PARAMS_MQTT_BINARY
+          if (binary) {
+            _paramsMqttPublishBinary(entry, entry->topic_subscribe, CONFIG_MQTT_PARAMS_RETAINED);
+            return;
+          };
+        #endif // CONFIG_PARAMS_MQTT_BINARY
+        mqttPublish(entry->topic_subscribe, value, 
+          entry->meta->qos, CONFIG_MQTT_PARAMS_RETAINED, 
+          false, false);
+        // entry->subscribed = mqttSubscribe(entry->topic_subscribe, entry->meta->qos);
       };
     } else {
       rlog_w(logTAG, "Call publication parameter of undetermined value!");
@@ -337,7 +1854,9 @@ void _paramsMqttPublishEntry(paramsEntryHandle_t entry)
 void paramsMqttPublishEntry(paramsEntryHandle_t entry)
 {
   if (mqttIsConnected()) {
-    _paramsMqttPublishEntry(entry);
+    paramsValueText_t text;
+    _paramsMqttPublishEntry(entry, _paramsMqttValueText(entry, &text));
+    _paramsValueTextFree(&text);
   }
 }
 
@@ -348,7 +1867,7 @@ bool _paramsMqttSubscribeEntry(paramsEntryHandle_t entry)
     paramsMqttTopicsCreateEntry(entry);
   };
   if (entry->topic_subscribe) {
-    return mqttSubscribe(entry->topic_subscribe, entry->qos);
+    return mqttSubscribe(entry->topic_subscribe, entry->meta->qos);
   };
   return false;
 };
@@ -365,8 +1884,15 @@ bool paramsMqttSubscribeEntry(paramsEntryHandle_t entry)
 
 bool _paramsMqttSubscribeWildcard()
 {
-  if (_paramsWildcardTopic) free(_paramsWildcardTopic);
-  _paramsWildcardTopic = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, "#", nullptr);
+  char* topic = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_PARAMS_TOPIC, "#", nullptr);
+  // The wildcard prefix is used by the incoming message handler without paramsLock
+  INDEX_LOCK();
+  char* prev_topic = _paramsWildcardTopic;
+  _paramsWildcardTopic = topic;
+  // Prefix without the trailing "#" is cut from incoming topics to get "group_topic/key"
+  _paramsWildcardPrefixLen = topic ? strlen(topic) - 1 : 0;
+  INDEX_UNLOCK();
+  if (prev_topic) free(prev_topic);
   if (_paramsWildcardTopic) {
     rlog_d(logTAG, "Generated subscription topic for all parameters: [ %s ]", _paramsWildcardTopic);
     return mqttSubscribe(_paramsWildcardTopic, CONFIG_MQTT_PARAMS_QOS);
@@ -378,38 +1904,161 @@ bool _paramsMqttSubscribeWildcard()
 
 void paramsMqttFreeWildcard()
 {
-  if (_paramsWildcardTopic) free(_paramsWildcardTopic);
+  INDEX_LOCK();
+  char* prev_topic = _paramsWildcardTopic;
   _paramsWildcardTopic = nullptr;
+  _paramsWildcardPrefixLen = 0;
+  INDEX_UNLOCK();
+  if (prev_topic) free(prev_topic);
   rlog_d(logTAG, "Topics for all parameters has been scrapped");
 }
 
 #endif // CONFIG_MQTT_PARAMS_WILDCARD  
 
-void paramsMqttPublish(paramsEntryHandle_t entry, bool publish_in_mqtt)
+// value - text representation of the current value, formatted once by the caller
+static void _paramsMqttPublishNow(paramsEntryHandle_t entry, bool publish_in_mqtt, char* value)
 {
   if (mqttIsConnected()) {
     // Parameters
     if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
       #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-        _paramsMqttConfirmEntry(entry);
+        _paramsMqttConfirmEntry(entry, value);
       #else
         if (publish_in_mqtt) {
-          _paramsMqttPublishEntry(entry);
+          _paramsMqttPublishEntry(entry, value);
         };
       #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
     } else if (entry->type_param == OPT_KIND_PARAMETER_LOCATION) {
       if (publish_in_mqtt) {
-        _paramsMqttPublishEntry(entry);
+        _paramsMqttPublishEntry(entry, value);
+      };
+    };
+  };
+}
+
+#if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+
+// Publishing is deferred to the timer, the pending flag is the only slot of the parameter in the queue, 
+// so a new value simply replaces the previous one. Returns false if there is nothing to publish
+static bool _paramsMqttPublishDefer(paramsEntryHandle_t entry, bool publish_in_mqtt)
+{
+  bool needed = false;
+  if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
+    #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
+      needed = true;
+    #else
+      needed = publish_in_mqtt;
+    #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
+  } else if (entry->type_param == OPT_KIND_PARAMETER_LOCATION) {
+    needed = publish_in_mqtt;
+  };
+  if (needed) {
+    // Called without locks, the flag occupies its own byte and is set atomically
+    __atomic_store_n(&entry->publish_pending, true, __ATOMIC_RELEASE);
+    if (xTimerIsTimerActive(paramsPublishTimer) == pdFALSE) {
+      xTimerStart(paramsPublishTimer, 0);
+    };
+  };
+  return needed;
+}
+
+// Topic generation, formatting and network I/O are not performed in the timer service task, 
+// the timer only wakes up the worker task
+static void paramsPublishTimerCallback(TimerHandle_t timer)
+{
+  xTaskNotify(paramsWorkerTask, PARAMS_WORK_PUBLISH, eSetBits);
+}
+
+// Publish no more than CONFIG_PARAMS_MQTT_PUBLISH_LIMIT pending parameters, starting from where the previous 
+// period stopped (called by the worker task). The list of parameters is append-only, so it can be walked without paramsLock
+static void _paramsPublishPending()
+{
+  bool pending = false;
+  if (mqttIsConnected() && (paramsList) && STAILQ_FIRST(paramsList)) {
+    if (mqttGetOutboxSize() > CONFIG_PARAMS_MQTT_OUTBOX_HIGH) {
+      // The network does not keep up, skip this period
+      pending = true;
+    } else {
+      uint16_t count = 0;
+      paramsEntryHandle_t item = _paramsPublishNext ? _paramsPublishNext : STAILQ_FIRST(paramsList);
+      paramsEntryHandle_t first = item;
+      do {
+        if (__atomic_load_n(&item->publish_pending, __ATOMIC_ACQUIRE)) {
+          if (count >= CONFIG_PARAMS_MQTT_PUBLISH_LIMIT) {
+            pending = true;
+            break;
+          };
+          // Do not wait for a busy group, its values will be published in the next period
+          if (xSemaphoreTake(_paramsEntryLock(item), 0) == pdTRUE) {
+            __atomic_store_n(&item->publish_pending, false, __ATOMIC_RELEASE);
+            paramsValueText_t text;
+            _paramsMqttPublishNow(item, true, _paramsMqttValueText(item, &text));
+            _paramsValueTextFree(&text);
+            ENTRY_UNLOCK(item);
+            count++;
+          } else {
+            pending = true;
+          };
+        };
+        item = STAILQ_NEXT(item, next);
+        if (item == nullptr) item = STAILQ_FIRST(paramsList);
+      } while (item != first);
+      _paramsPublishNext = item;
+    };
+  };
+  // Values that were not published before the connection was lost stay pending until the subscription pass 
+  // after reconnection is completed (see _paramsPublishResume())
+  if ((pending) && (paramsPublishTimer)) {
+    xTimerStart(paramsPublishTimer, 0);
+  };
+}
+
+// Restart publishing of the values that are still pending, for example deferred just before the connection was lost
+static void _paramsPublishResume()
+{
+  if ((paramsPublishTimer) && (paramsList)) {
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      if (__atomic_load_n(&item->publish_pending, __ATOMIC_ACQUIRE)) {
+        if (xTimerIsTimerActive(paramsPublishTimer) == pdFALSE) {
+          xTimerStart(paramsPublishTimer, 0);
+        };
+        return;
       };
     };
   };
 }
 
-bool _paramsMqttSubscribe(paramsEntryHandle_t entry)
+#endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+
+static void _paramsMqttPublish(paramsEntryHandle_t entry, bool publish_in_mqtt, char* value)
+{
+  #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+    if ((paramsPublishTimer) && _paramsMqttPublishDefer(entry, publish_in_mqtt)) return;
+  #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+  _paramsMqttPublishNow(entry, publish_in_mqtt, value);
+}
+
+void paramsMqttPublish(paramsEntryHandle_t entry, bool publish_in_mqtt)
+{
+  if (mqttIsConnected()) {
+    #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+      if ((paramsPublishTimer) && _paramsMqttPublishDefer(entry, publish_in_mqtt)) return;
+    #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+    paramsValueText_t text;
+    _paramsMqttPublish(entry, publish_in_mqtt, _paramsMqttValueText(entry, &text));
+    _paramsValueTextFree(&text);
+  };
+}
+
+// Create topics and publish the current value before subscribing
+static void _paramsMqttSubscribePrepare(paramsEntryHandle_t entry)
 {
-  // Create new topics
-  paramsMqttTopicsFreeEntry(entry);
-  paramsMqttTopicsCreateEntry(entry);
+  // Create topics if they have not yet been generated
+  if (!_paramsMqttTopicsReady(entry)) {
+    paramsMqttTopicsFreeEntry(entry);
+    paramsMqttTopicsCreateEntry(entry);
+  };
 
   // Publish current value
   if (entry->type_param == OPT_KIND_PARAMETER_LOCATION) {
@@ -418,10 +2067,17 @@ bool _paramsMqttSubscribe(paramsEntryHandle_t entry)
   } else {
     #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
       if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
-        _paramsMqttConfirmEntry(entry);
+        paramsValueText_t text;
+        _paramsMqttConfirmEntry(entry, _paramsMqttValueText(entry, &text));
+        _paramsValueTextFree(&text);
       };
     #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
   };
+}
+
+bool _paramsMqttSubscribe(paramsEntryHandle_t entry)
+{
+  _paramsMqttSubscribePrepare(entry);
 
   // Subscribe to topic
   #if CONFIG_MQTT_PARAMS_WILDCARD
@@ -440,23 +2096,140 @@ void paramsMqttSubscribe(paramsEntryHandle_t entry)
   entry->subscribed = mqttIsConnected() && _paramsMqttSubscribe(entry);
 }
 
+// Topics of one qos waiting to be subscribed
+typedef struct {
+  size_t count;
+  paramsEntryHandle_t entries[CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH];
+  const char* topics[CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH];
+  int qos[CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH];
+} paramsSubscribeBatch_t;
+
+// Batches are used only by the subscription pass under paramsSubscribeLock
+static paramsSubscribeBatch_t _paramsSubscribeBatches[3];
+static params_subscribe_batch_t _paramsSubscribeBatch = nullptr;
+
+void paramsMqttSetSubscribeBatch(params_subscribe_batch_t subscribe)
+{
+  _paramsSubscribeBatch = subscribe;
+}
+
+// Flow control is used only by the subscription pass under paramsSubscribeLock
+static paramsFlowStats_t _paramsFlowStats = {0, 0, 0, 0};
+
+void paramsMqttFlowStats(paramsFlowStats_t* stats)
+{
+  if (stats) {
+    *stats = _paramsFlowStats;
+  };
+}
+
+// Pause while the outbox is above the high watermark. The length of each sleep is calculated from the observed
+// drain rate so that the outbox reaches the low watermark, if the outbox does not drain, the estimation is halved
+static void _paramsMqttOutboxWait()
+{
+  int size = mqttGetOutboxSize();
+  if ((size <= CONFIG_PARAMS_MQTT_OUTBOX_HIGH) || !mqttIsConnected()) return;
+
+  rlog_v(logTAG, "Waiting for previous data to be sent from outbox (%d bytes)...", size);
+  const TickType_t max_delay = pdMS_TO_TICKS(100) > 0 ? pdMS_TO_TICKS(100) : 1;
+  TickType_t start = xTaskGetTickCount();
+  _paramsFlowStats.throttled++;
+  while ((size > CONFIG_PARAMS_MQTT_OUTBOX_LOW) && mqttIsConnected()) {
+    if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(CONFIG_PARAMS_MQTT_OUTBOX_TIMEOUT)) {
+      rlog_w(logTAG, "Outbox is not drained in %d ms (%d bytes)", CONFIG_PARAMS_MQTT_OUTBOX_TIMEOUT, size);
+      _paramsFlowStats.timeouts++;
+      break;
+    };
+    TickType_t delay = max_delay;
+    if (_paramsFlowStats.drain_rate > 0) {
+      delay = pdMS_TO_TICKS((uint64_t)(size - CONFIG_PARAMS_MQTT_OUTBOX_LOW) * 1000 / _paramsFlowStats.drain_rate);
+      if (delay < 1) delay = 1;
+      if (delay > max_delay) delay = max_delay;
+    };
+    TickType_t sleep_start = xTaskGetTickCount();
+    vTaskDelay(delay);
+    int drained = size;
+    size = mqttGetOutboxSize();
+    drained -= size;
+    uint32_t elapsed_ms = (xTaskGetTickCount() - sleep_start) * portTICK_PERIOD_MS;
+    if ((drained > 0) && (elapsed_ms > 0)) {
+      uint32_t rate = (uint32_t)((uint64_t)drained * 1000 / elapsed_ms);
+      _paramsFlowStats.drain_rate = _paramsFlowStats.drain_rate > 0 ? (_paramsFlowStats.drain_rate * 3 + rate) / 4 : rate;
+    } else {
+      _paramsFlowStats.drain_rate /= 2;
+    };
+  };
+  _paramsFlowStats.throttled_ms += (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+}
+
+// Subscribe to all topics of the batch, returns false if the connection to the broker was lost
+static bool _paramsMqttBatchFlush(paramsSubscribeBatch_t* batch)
+{
+  if (batch->count > 0) {
+    _paramsMqttOutboxWait();
+    if (!mqttIsConnected()) {
+      batch->count = 0;
+      return false;
+    };
+    bool batch_ok = (_paramsSubscribeBatch) && _paramsSubscribeBatch(batch->topics, batch->qos, batch->count);
+    for (size_t i = 0; i < batch->count; i++) {
+      paramsEntryHandle_t entry = batch->entries[i];
+      bool entry_ok = _paramsSubscribeBatch ? batch_ok : mqttSubscribe(batch->topics[i], batch->qos[i]);
+      ENTRY_LOCK(entry);
+      entry->subscribed = entry_ok && mqttIsConnected();
+      ENTRY_UNLOCK(entry);
+    };
+    rlog_v(logTAG, "Subscribed to %d topics with qos %d", (int)batch->count, batch->qos[0]);
+    batch->count = 0;
+    vTaskDelay(1);
+  };
+  return true;
+}
+
+// Prepare the entry and add its topic to the batch for its qos (the wildcard topic is subscribed immediately).
+// Returns the batch if it is full. The caller holds paramsLock
+static paramsSubscribeBatch_t* _paramsMqttBatchAdd(paramsEntryHandle_t entry)
+{
+  paramsSubscribeBatch_t* batch = nullptr;
+  ENTRY_LOCK(entry);
+  _paramsMqttSubscribePrepare(entry);
+  #if CONFIG_MQTT_PARAMS_WILDCARD
+  if (_paramsMqttIsWildcard(entry)) {
+    entry->subscribed = (_paramsWildcardTopic) || _paramsMqttSubscribeWildcard();
+  } else
+  #endif // CONFIG_MQTT_PARAMS_WILDCARD
+  if (entry->topic_subscribe) {
+    batch = &_paramsSubscribeBatches[entry->meta->qos < 2 ? entry->meta->qos : 2];
+    batch->entries[batch->count] = entry;
+    batch->topics[batch->count] = entry->topic_subscribe;
+    batch->qos[batch->count] = entry->meta->qos;
+    batch->count++;
+  } else {
+    entry->subscribed = false;
+  };
+  ENTRY_UNLOCK(entry);
+  if ((batch) && (batch->count >= CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH)) {
+    return batch;
+  };
+  return nullptr;
+}
+
 void _paramsMqttUnubscribe(paramsEntryHandle_t entry)
 {
   // Everything except outgoing data
   if (entry->subscribed) {
-    #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-      if ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)) {
+    #if CONFIG_MQTT_PARAMS_WILDCARD
+      if (_paramsMqttIsWildcard(entry)) {
         if (_paramsWildcardTopic) {
           mqttUnsubscribe(_paramsWildcardTopic);
-          free(_paramsWildcardTopic);
-          _paramsWildcardTopic = nullptr;
+          paramsMqttFreeWildcard();
         };
       } else {
         mqttUnsubscribe(entry->topic_subscribe);
       };
     #else
       mqttUnsubscribe(entry->topic_subscribe);
-    #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED 
+    #endif // CONFIG_MQTT_PARAMS_WILDCARD
   };
   entry->subscribed = false;
 }
@@ -483,22 +2256,15 @@ paramsGroupHandle_t paramsRegisterGroup(paramsGroup_t* parent_group, const char*
   OPTIONS_LOCK();
 
   if (paramsGroups) {
-    STAILQ_FOREACH(item, paramsGroups, next) {
-      if (name_key) {
-        if ((item->parent == parent_group) && (strcasecmp(item->key, name_key) == 0)) {
-          OPTIONS_UNLOCK();
-          return item;
-        };
-      } else {
-        if ((item->parent == parent_group) && (item->key == nullptr)) {
-          OPTIONS_UNLOCK();
-          return item;
-        };
-      };
+    item = _paramsGroupIndexFind(parent_group, name_key);
+    if (item) {
+      OPTIONS_UNLOCK();
+      return item;
     };
 
-    item = (paramsGroupHandle_t)esp_calloc(1, sizeof(paramsGroup_t));
+    item = (paramsGroupHandle_t)_paramsPoolAlloc(&_paramsGroupPool, sizeof(paramsGroup_t));
     if (item) {
+      _paramsGroupCount++;
       item->parent = parent_group;
       if (item->parent) {
         if (item->parent->key) {
@@ -524,7 +2290,12 @@ paramsGroupHandle_t paramsRegisterGroup(paramsGroup_t* parent_group, const char*
       if ((item->key) && (strlen(item->key) > 15)) {
         rlog_w(logTAG, "The group key name [%s] is too long!", item->key);
       };
+      item->lock = xSemaphoreCreateMutex();
+      if (!item->lock) {
+        rlog_w(logTAG, "Can't create mutex for group [%s], common lock will be used", item->key);
+      };
       STAILQ_INSERT_TAIL(paramsGroups, item, next);
+      _paramsGroupIndexInsert(item);
     };
   };
 
@@ -533,6 +2304,28 @@ paramsGroupHandle_t paramsRegisterGroup(paramsGroup_t* parent_group, const char*
   return item;
 }
 
+// Add a new parameter to the list and indexes. The caller holds paramsLock and the lock of the group
+static void _paramsEntryLink(paramsEntryHandle_t item)
+{
+  _paramsEntryCount++;
+  STAILQ_INSERT_TAIL(paramsList, item, next);
+  _paramsKeyIndexInsert(item);
+  _paramsTopicsComplete = false;
+  #if CONFIG_MQTT_PARAMS_WILDCARD
+    if (_paramsMqttIsWildcard(item)) {
+      _paramsTopicIndexInsertRoute(item);
+    };
+  #endif // CONFIG_MQTT_PARAMS_WILDCARD
+}
+
+static bool _paramsEntryIsRestored(paramsEntryHandle_t item)
+{
+  return (item->type_param == OPT_KIND_PARAMETER) 
+      || (item->type_param == OPT_KIND_PARAMETER_LOCATION) 
+      || (item->type_param == OPT_KIND_LOCDATA_STORED)
+      || (item->type_param == OPT_KIND_EXTDATA_STORED);
+}
+
 paramsEntryHandle_t paramsRegisterValueEx(const param_kind_t type_param, const param_type_t type_value, 
   param_handler_type_t handler_type, void* change_handler,
   paramsGroupHandle_t parent_group, 
@@ -548,86 +2341,66 @@ paramsEntryHandle_t paramsRegisterValueEx(const param_kind_t type_param, const p
   OPTIONS_LOCK();
 
   if (paramsList) {
-    STAILQ_FOREACH(item, paramsList, next) {
-      if ((item->group == parent_group) && (strcasecmp(item->key, name_key) == 0)) {
-        OPTIONS_UNLOCK();
-        return item;
-      };
+    item = _paramsKeyIndexFind(parent_group, name_key);
+    if (item) {
+      OPTIONS_UNLOCK();
+      return item;
     };
 
-    item = (paramsEntryHandle_t)esp_calloc(1, sizeof(paramsEntry_t));
-    if (item) {
-      if (value) {
-        item->id = (uint32_t)value;
-      } else {
-        item->id = 0;
-      };
+    item = (paramsEntryHandle_t)_paramsPoolAlloc(&_paramsEntryPool, sizeof(paramsEntry_t));
+    paramsEntryMeta_t* meta = item ? _paramsMetaAlloc() : nullptr;
+    if (item && meta) {
+      meta->type_handler = handler_type;
+      meta->handler = change_handler;
+      meta->friendly = name_friendly;
+      meta->qos = qos;
+      meta->has_limits = false;
+      item->meta = meta;
+      item->meta_const = false;
       item->type_param = type_param;
       item->type_value = type_value;
-      item->type_handler = handler_type;
-      item->handler = change_handler;
-      item->friendly = name_friendly;
       item->group = parent_group;
       item->key = name_key;
       item->notify = true;
       item->locked = false;
       item->subscribed = false;
       item->topic_subscribe = nullptr;
-      #if CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
       item->topic_publish = nullptr;
-      #endif // CONFIG_MQTT_PARAMS_CONFIRM_ENABLED
-      item->qos = qos;
       item->value = value;
-      item->min_value = nullptr;
-      item->max_value = nullptr;
+      item->topic_hash = 0;
+      item->topic_next = nullptr;
+      // The new parameter becomes visible to other tasks as soon as it is added to the list
+      ENTRY_LOCK(item);
       // Append item to list
-      STAILQ_INSERT_TAIL(paramsList, item, next);
+      _paramsEntryLink(item);
       // Read value from NVS storage
       if ((item->type_param == OPT_KIND_COMMAND) || (item->type_param == OPT_KIND_OTA)) {
         rlog_d(logTAG, "System handler \"%s\" registered", item->key);
       } else if ((item->type_param == OPT_KIND_SIGNAL) || (item->type_param == OPT_KIND_SIGNAL_AUTOCLR)) {
         rlog_d(logTAG, "Signal \"%s\" registered", item->key);
       } else {
-        if ((item->type_param == OPT_KIND_PARAMETER) 
-         || (item->type_param == OPT_KIND_PARAMETER_LOCATION) 
-         || (item->type_param == OPT_KIND_LOCDATA_STORED)
-         || (item->type_param == OPT_KIND_EXTDATA_STORED)) 
-        {
-          void* prev_value = clone2value(item->type_value, item->value);
-          if ((item->group) && (item->group->key)) {
-            nvsRead(item->group->key, item->key, item->type_value, item->value);
-          };
-          if (prev_value) {
-            if (!equal2value(item->type_value, prev_value, item->value)) {
-              if (item->type_handler > PARAM_HANDLER_NONE) {
-                if (item->id > 0) {
-                  eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_RESTORED, &item->id, sizeof(item->id), portMAX_DELAY);
-                };
-                if ((item->type_handler = PARAM_HANDLER_CLASS) && (item->handler)) {
-                  param_handler_t* hdr = (param_handler_t*)item->handler;
-                  hdr->onChange(PARAM_NVS_RESTORED);
-                } else if ((item->type_handler = PARAM_HANDLER_CALLBACK) && (item->handler)) {
-                  params_callback_t cbf = (params_callback_t)item->handler;
-                  cbf(item, PARAM_NVS_RESTORED, item->value);
-                };
-              };
-            };
-            free(prev_value);
-          };
+        if (_paramsEntryIsRestored(item)) {
+          #if CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+            item->restore_pending = (item->group) && (item->group->key);
+          #else
+            _paramsNvsRestore(item);
+          #endif // CONFIG_PARAMS_NVS_DEFERRED_RESTORE
         };
 
-        char* str_value = value2string(item->type_value, item->value);
+        paramsValueText_t text;
+        char* str_value = _paramsValueFormat(item, &text);
         if (str_value) {
           if ((item->group) && (item->group->key)) {
             rlog_d(logTAG, "Parameter \"%s.%s\": [%s] registered", item->group->key, item->key, str_value);
           } else {
             rlog_d(logTAG, "Parameter \"%s\": [%s] registered", item->key, str_value);
           };
-          free(str_value);
         };
+        _paramsValueTextFree(&text);
       };
       // We try to subscribe if the connection to the server is already established
       paramsMqttSubscribe(item);
+      ENTRY_UNLOCK(item);
     };
   };
   
@@ -636,6 +2409,75 @@ paramsEntryHandle_t paramsRegisterValueEx(const param_kind_t type_param, const p
   return item;
 }
 
+bool paramsRegisterTable(paramsGroupHandle_t parent_group, const paramsDescriptor_t* table, size_t count, paramsEntryHandle_t* entries)
+{
+  bool ret = false;
+
+  if ((table == nullptr) || (count == 0)) {
+    return false;
+  };
+  if (!paramsList) {
+    paramsInit();
+  };
+
+  OPTIONS_LOCK();
+
+  if (paramsList) {
+    // Entries of the whole table are allocated as one array, the metadata remains in the table
+    paramsEntryHandle_t items = (paramsEntryHandle_t)_paramsPoolAlloc(&_paramsEntryPool, count * sizeof(paramsEntry_t));
+    if (items) {
+      ret = true;
+      paramsEntryHandle_t first_restored = nullptr;
+      uint16_t registered = 0;
+      // All parameters of the table belong to one group and share its lock
+      items[0].group = parent_group;
+      ENTRY_LOCK(&items[0]);
+      for (size_t i = 0; i < count; i++) {
+        paramsEntryHandle_t item = _paramsKeyIndexFind(parent_group, table[i].key);
+        if (item == nullptr) {
+          item = &items[i];
+          item->meta = &table[i].meta;
+          item->meta_const = true;
+          item->type_param = table[i].type_param;
+          item->type_value = table[i].type_value;
+          item->group = parent_group;
+          item->key = table[i].key;
+          item->value = table[i].value;
+          item->notify = true;
+          _paramsEntryLink(item);
+          if (_paramsEntryIsRestored(item) && (parent_group) && (parent_group->key)) {
+            item->restore_pending = true;
+            if (first_restored == nullptr) first_restored = item;
+          };
+          registered++;
+        };
+        if (entries) entries[i] = item;
+      };
+      // Read all values of the table from NVS, opening the namespace only once
+      #if !CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+        if (first_restored) {
+          _paramsNvsRestoreGroup(first_restored);
+        };
+      #endif // CONFIG_PARAMS_NVS_DEFERRED_RESTORE
+      // We try to subscribe if the connection to the server is already established
+      if (mqttIsConnected()) {
+        for (size_t i = 0; i < count; i++) {
+          if (items[i].meta) {
+            paramsMqttSubscribe(&items[i]);
+          };
+        };
+      };
+      ENTRY_UNLOCK(&items[0]);
+      rlog_d(logTAG, "Registered %d parameters of group \"%s\"", registered, 
+        (parent_group) && (parent_group->key) ? parent_group->key : CONFIG_MQTT_COMMON_TOPIC);
+    };
+  };
+
+  OPTIONS_UNLOCK();
+
+  return ret;
+}
+
 paramsEntryHandle_t paramsRegisterCommonValueEx(const param_kind_t type_param, const param_type_t type_value, 
   param_handler_type_t handler_type, void* change_handler,
   const char* name_key, const char* name_friendly, const int qos, 
@@ -658,144 +2500,381 @@ paramsEntryHandle_t paramsRegisterCommonValueEx(const param_kind_t type_param, c
 // ------------------------------------------------------- Limits --------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-void paramsSetLimitsI8(paramsEntryHandle_t entry, int8_t min_value, int8_t max_value)
+// Metadata of parameters registered from a table is located in flash, it is copied to RAM on the first change.
+// The caller holds the lock of the group
+static paramsEntryMeta_t* _paramsEntryMetaWritable(paramsEntryHandle_t entry)
 {
-  if (entry) {
-    entry->min_value = (int8_t*)esp_calloc(1, sizeof(int8_t));
-    if (entry->min_value) {
-      *(int8_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (int8_t*)esp_calloc(1, sizeof(int8_t));
-    if (entry->max_value) {
-      *(int8_t*)entry->max_value = max_value;
-    };
+  if (entry->meta_const) {
+    paramsEntryMeta_t* meta = _paramsMetaAlloc();
+    if (meta == nullptr) return nullptr;
+    memcpy(meta, entry->meta, sizeof(paramsEntryMeta_t));
+    entry->meta = meta;
+    entry->meta_const = false;
   };
+  return (paramsEntryMeta_t*)entry->meta;
 }
 
-void paramsSetLimitsU8(paramsEntryHandle_t entry, uint8_t min_value, uint8_t max_value)
+// Setters of the metadata can be called from a change handler, which is called with the lock of the group 
+// held by the same task. Returns false if the lock is already held and must not be released by the caller
+static bool _paramsEntryLockReentrant(paramsEntryHandle_t entry)
 {
-  if (entry) {
-    entry->min_value = (uint8_t*)esp_calloc(1, sizeof(uint8_t));
-    if (entry->min_value) {
-      *(uint8_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (uint8_t*)esp_calloc(1, sizeof(uint8_t));
-    if (entry->max_value) {
-      *(uint8_t*)entry->max_value = max_value;
-    };
+  SemaphoreHandle_t lock = _paramsEntryLock(entry);
+  if (xSemaphoreGetMutexHolder(lock) == xTaskGetCurrentTaskHandle()) {
+    return false;
   };
+  xSemaphoreTake(lock, portMAX_DELAY);
+  return true;
 }
 
-void paramsSetLimitsI16(paramsEntryHandle_t entry, int16_t min_value, int16_t max_value)
+// Limits are stored inline in the metadata, repeated calls simply overwrite them
+#define PARAMS_SET_LIMITS(name, type_c, field) \
+  void name(paramsEntryHandle_t entry, type_c min_value, type_c max_value) \
+  { \
+    if (entry) { \
+      bool locked = _paramsEntryLockReentrant(entry); \
+      paramsEntryMeta_t* meta = _paramsEntryMetaWritable(entry); \
+      if (meta) { \
+        meta->min_value.field = min_value; \
+        meta->max_value.field = max_value; \
+        meta->has_limits = true; \
+      }; \
+      if (locked) ENTRY_UNLOCK(entry); \
+    }; \
+  }
+
+PARAMS_SET_LIMITS(paramsSetLimitsI8, int8_t, i8)
+PARAMS_SET_LIMITS(paramsSetLimitsU8, uint8_t, u8)
+PARAMS_SET_LIMITS(paramsSetLimitsI16, int16_t, i16)
+PARAMS_SET_LIMITS(paramsSetLimitsU16, uint16_t, u16)
+PARAMS_SET_LIMITS(paramsSetLimitsI32, int32_t, i32)
+PARAMS_SET_LIMITS(paramsSetLimitsU32, uint32_t, u32)
+PARAMS_SET_LIMITS(paramsSetLimitsI64, int64_t, i64)
+PARAMS_SET_LIMITS(paramsSetLimitsU64, uint64_t, u64)
+PARAMS_SET_LIMITS(paramsSetLimitsFloat, float, f)
+PARAMS_SET_LIMITS(paramsSetLimitsDouble, double, d)
+
+void paramsSetValueOps(paramsEntryHandle_t entry, const paramsValueOps_t* ops)
 {
   if (entry) {
-    entry->min_value = (int16_t*)esp_calloc(1, sizeof(int16_t));
-    if (entry->min_value) {
-      *(int16_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (int16_t*)esp_calloc(1, sizeof(int16_t));
-    if (entry->max_value) {
-      *(int16_t*)entry->max_value = max_value;
+    bool locked = _paramsEntryLockReentrant(entry);
+    paramsEntryMeta_t* meta = _paramsEntryMetaWritable(entry);
+    if (meta) {
+      meta->ops = ops;
     };
+    if (locked) ENTRY_UNLOCK(entry);
   };
 }
 
-void paramsSetLimitsU16(paramsEntryHandle_t entry, uint16_t min_value, uint16_t max_value)
+void paramsSetBinary(paramsEntryHandle_t entry, bool binary)
 {
   if (entry) {
-    entry->min_value = (uint16_t*)esp_calloc(1, sizeof(uint16_t));
-    if (entry->min_value) {
-      *(uint16_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (uint16_t*)esp_calloc(1, sizeof(uint16_t));
-    if (entry->max_value) {
-      *(uint16_t*)entry->max_value = max_value;
-    };
+    ENTRY_LOCK(entry);
+    entry->binary = binary;
+    ENTRY_UNLOCK(entry);
   };
 }
 
-void paramsSetLimitsI32(paramsEntryHandle_t entry, int32_t min_value, int32_t max_value)
+void paramsSetGroupBinary(paramsGroupHandle_t group, bool binary)
 {
-  if (entry) {
-    entry->min_value = (int32_t*)esp_calloc(1, sizeof(int32_t));
-    if (entry->min_value) {
-      *(int32_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (int32_t*)esp_calloc(1, sizeof(int32_t));
-    if (entry->max_value) {
-      *(int32_t*)entry->max_value = max_value;
-    };
+  if (group) {
+    if (group->lock) xSemaphoreTake((SemaphoreHandle_t)group->lock, portMAX_DELAY);
+    group->binary = binary;
+    if (group->lock) xSemaphoreGive((SemaphoreHandle_t)group->lock);
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- Export --------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+  params_export_writer_t writer;
+  void* ctx;
+  params_export_format_t format;
+  bool ok;
+  size_t len;
+  uint8_t buf[CONFIG_PARAMS_EXPORT_BUFFER_SIZE];
+} paramsExport_t;
+
+static void _paramsExportFlush(paramsExport_t* exp)
+{
+  if ((exp->ok) && (exp->len > 0)) {
+    exp->ok = exp->writer(exp->buf, exp->len, exp->ctx);
   };
+  exp->len = 0;
 }
 
-void paramsSetLimitsU32(paramsEntryHandle_t entry, uint32_t min_value, uint32_t max_value)
+static void _paramsExportWrite(paramsExport_t* exp, const void* data, size_t size)
 {
-  if (entry) {
-    entry->min_value = (uint32_t*)esp_calloc(1, sizeof(uint32_t));
-    if (entry->min_value) {
-      *(uint32_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (uint32_t*)esp_calloc(1, sizeof(uint32_t));
-    if (entry->max_value) {
-      *(uint32_t*)entry->max_value = max_value;
+  const uint8_t* src = (const uint8_t*)data;
+  while ((exp->ok) && (size > 0)) {
+    size_t part = sizeof(exp->buf) - exp->len;
+    if (part > size) part = size;
+    memcpy(exp->buf + exp->len, src, part);
+    exp->len += part;
+    src += part;
+    size -= part;
+    if (exp->len == sizeof(exp->buf)) {
+      _paramsExportFlush(exp);
     };
   };
 }
 
-void paramsSetLimitsI64(paramsEntryHandle_t entry, int64_t min_value, int64_t max_value)
+static void _paramsExportByte(paramsExport_t* exp, uint8_t data)
 {
-  if (entry) {
-    entry->min_value = (int64_t*)esp_calloc(1, sizeof(int64_t));
-    if (entry->min_value) {
-      *(int64_t*)entry->min_value = min_value;
-    };
-    entry->max_value = (int64_t*)esp_calloc(1, sizeof(int64_t));
-    if (entry->max_value) {
-      *(int64_t*)entry->max_value = max_value;
+  _paramsExportWrite(exp, &data, 1);
+}
+
+// CBOR: initial byte and argument of the data item in network byte order
+static void _paramsExportCborHead(paramsExport_t* exp, uint8_t major, uint64_t value)
+{
+  uint8_t head[9];
+  size_t size;
+  if (value < 24) {
+    head[0] = (major << 5) | (uint8_t)value;
+    size = 0;
+  } else if (value <= UINT8_MAX) {
+    head[0] = (major << 5) | 24;
+    size = 1;
+  } else if (value <= UINT16_MAX) {
+    head[0] = (major << 5) | 25;
+    size = 2;
+  } else if (value <= UINT32_MAX) {
+    head[0] = (major << 5) | 26;
+    size = 4;
+  } else {
+    head[0] = (major << 5) | 27;
+    size = 8;
+  };
+  for (size_t i = 0; i < size; i++) {
+    head[size - i] = (uint8_t)(value >> (8 * i));
+  };
+  _paramsExportWrite(exp, head, size + 1);
+}
+
+static void _paramsExportCborInt(paramsExport_t* exp, int64_t value)
+{
+  if (value >= 0) {
+    _paramsExportCborHead(exp, 0, (uint64_t)value);
+  } else {
+    _paramsExportCborHead(exp, 1, (uint64_t)(-1 - value));
+  };
+}
+
+// JSON: string in quotes with escaping of special characters
+static void _paramsExportJsonString(paramsExport_t* exp, const char* str)
+{
+  _paramsExportByte(exp, '"');
+  while (*str) {
+    unsigned char c = (unsigned char)*str++;
+    if ((c == '"') || (c == '\\')) {
+      _paramsExportByte(exp, '\\');
+      _paramsExportByte(exp, c);
+    } else if (c < 0x20) {
+      char esc[8];
+      int len = snprintf(esc, sizeof(esc), "\\u%04x", c);
+      _paramsExportWrite(exp, esc, len);
+    } else {
+      _paramsExportByte(exp, c);
     };
   };
+  _paramsExportByte(exp, '"');
 }
 
-void paramsSetLimitsU64(paramsEntryHandle_t entry, uint64_t min_value, uint64_t max_value)
+static void _paramsExportString(paramsExport_t* exp, const char* str)
 {
-  if (entry) {
-    entry->min_value = (uint64_t*)esp_calloc(1, sizeof(uint64_t));
-    if (entry->min_value) {
-      *(uint64_t*)entry->min_value = min_value;
+  if (exp->format == PARAMS_EXPORT_CBOR) {
+    size_t len = strlen(str);
+    _paramsExportCborHead(exp, 3, len);
+    _paramsExportWrite(exp, str, len);
+  } else {
+    _paramsExportJsonString(exp, str);
+  };
+}
+
+// Value is read without locks (see _paramsValueRead), long strings are truncated
+static void _paramsExportValue(paramsExport_t* exp, paramsEntryHandle_t entry)
+{
+  if (entry->type_value == OPT_TYPE_STRING) {
+    char str[CONFIG_PARAMS_EXPORT_STRING_SIZE];
+    if (!_paramsValueRead(entry, str, sizeof(str), true)) str[0] = '\0';
+    _paramsExportString(exp, str);
+    return;
+  };
+
+  paramsValue_t value;
+  if (!_paramsValueRead(entry, &value, _paramsValueSize(entry->type_value), false)) {
+    if (exp->format == PARAMS_EXPORT_CBOR) {
+      _paramsExportByte(exp, 0xF6);
+    } else {
+      _paramsExportWrite(exp, "null", 4);
+    };
+    return;
+  };
+
+  if (exp->format == PARAMS_EXPORT_CBOR) {
+    switch (entry->type_value) {
+      case OPT_TYPE_I8:  _paramsExportCborInt(exp, value.i8); break;
+      case OPT_TYPE_U8:  _paramsExportCborHead(exp, 0, value.u8); break;
+      case OPT_TYPE_I16: _paramsExportCborInt(exp, value.i16); break;
+      case OPT_TYPE_U16: _paramsExportCborHead(exp, 0, value.u16); break;
+      case OPT_TYPE_I32: _paramsExportCborInt(exp, value.i32); break;
+      case OPT_TYPE_U32: _paramsExportCborHead(exp, 0, value.u32); break;
+      case OPT_TYPE_I64: _paramsExportCborInt(exp, value.i64); break;
+      case OPT_TYPE_U64: _paramsExportCborHead(exp, 0, value.u64); break;
+      case OPT_TYPE_FLOAT:
+      {
+        uint32_t bits;
+        memcpy(&bits, &value.f, sizeof(bits));
+        uint8_t data[5] = { 0xFA, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+        _paramsExportWrite(exp, data, sizeof(data));
+        break;
+      };
+      case OPT_TYPE_DOUBLE:
+      {
+        uint64_t bits;
+        memcpy(&bits, &value.d, sizeof(bits));
+        _paramsExportByte(exp, 0xFB);
+        for (int i = 7; i >= 0; i--) {
+          _paramsExportByte(exp, (uint8_t)(bits >> (8 * i)));
+        };
+        break;
+      };
+      default: 
+        _paramsExportByte(exp, 0xF6); 
+        break;
+    };
+  } else {
+    char buf[CONFIG_PARAMS_FORMAT_BUFFER_SIZE];
+    int len = -1;
+    switch (entry->type_value) {
+      case OPT_TYPE_I8:  len = snprintf(buf, sizeof(buf), "%d", value.i8); break;
+      case OPT_TYPE_U8:  len = snprintf(buf, sizeof(buf), "%u", value.u8); break;
+      case OPT_TYPE_I16: len = snprintf(buf, sizeof(buf), "%d", value.i16); break;
+      case OPT_TYPE_U16: len = snprintf(buf, sizeof(buf), "%u", value.u16); break;
+      case OPT_TYPE_I32: len = snprintf(buf, sizeof(buf), "%" PRIi32, value.i32); break;
+      case OPT_TYPE_U32: len = snprintf(buf, sizeof(buf), "%" PRIu32, value.u32); break;
+      case OPT_TYPE_I64: len = snprintf(buf, sizeof(buf), "%" PRIi64, value.i64); break;
+      case OPT_TYPE_U64: len = snprintf(buf, sizeof(buf), "%" PRIu64, value.u64); break;
+      case OPT_TYPE_FLOAT:
+        if (isfinite(value.f)) len = snprintf(buf, sizeof(buf), "%.7g", value.f); 
+        break;
+      case OPT_TYPE_DOUBLE: 
+        if (isfinite(value.d)) len = snprintf(buf, sizeof(buf), "%.15g", value.d); 
+        break;
+      default: break;
     };
-    entry->max_value = (uint64_t*)esp_calloc(1, sizeof(uint64_t));
-    if (entry->max_value) {
-      *(uint64_t*)entry->max_value = max_value;
+    if ((len > 0) && (len < (int)sizeof(buf))) {
+      _paramsExportWrite(exp, buf, len);
+    } else {
+      _paramsExportWrite(exp, "null", 4);
     };
   };
 }
 
-void paramsSetLimitsFloat(paramsEntryHandle_t entry, float min_value, float max_value)
+static bool _paramsExportEntry(paramsEntryHandle_t entry)
 {
-  if (entry) {
-    entry->min_value = (float*)esp_calloc(1, sizeof(float));
-    if (entry->min_value) {
-      *(float*)entry->min_value = min_value;
+  return (entry->value) && (entry->key)
+      && ((entry->type_param == OPT_KIND_PARAMETER) 
+       || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)
+       || (entry->type_param == OPT_KIND_PARAMETER_LOCATION) 
+       || (entry->type_param == OPT_KIND_LOCDATA_ONLINE) 
+       || (entry->type_param == OPT_KIND_LOCDATA_STORED)
+       || (entry->type_param == OPT_KIND_EXTDATA_ONLINE) 
+       || (entry->type_param == OPT_KIND_EXTDATA_STORED));
+}
+
+// The lists of groups and parameters are append-only and values are read consistently without locks, 
+// so the writer is never called while the parameters are locked. JSON is generated as is, 
+// CBOR uses maps of indefinite length, so the number of items does not need to be known in advance
+bool paramsExport(params_export_writer_t writer, void* ctx, params_export_format_t format)
+{
+  if ((writer == nullptr) || (paramsGroups == nullptr) || (paramsList == nullptr)) {
+    return false;
+  };
+
+  paramsExport_t exp;
+  exp.writer = writer;
+  exp.ctx = ctx;
+  exp.format = format;
+  exp.ok = true;
+  exp.len = 0;
+
+  bool cbor = format == PARAMS_EXPORT_CBOR;
+  bool first_group = true;
+  _paramsExportByte(&exp, cbor ? 0xBF : '{');
+  paramsGroupHandle_t group;
+  STAILQ_FOREACH(group, paramsGroups, next) {
+    if (!exp.ok) break;
+    if (group->key == nullptr) continue;
+    bool first_entry = true;
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      if ((item->group != group) || !_paramsExportEntry(item)) continue;
+      // The group is opened at its first parameter, empty groups are not exported
+      if (first_entry) {
+        if (!cbor && !first_group) _paramsExportByte(&exp, ',');
+        _paramsExportString(&exp, group->key);
+        _paramsExportByte(&exp, cbor ? 0xBF : ':');
+        if (!cbor) _paramsExportByte(&exp, '{');
+        first_entry = false;
+        first_group = false;
+      } else if (!cbor) {
+        _paramsExportByte(&exp, ',');
+      };
+      _paramsExportString(&exp, item->key);
+      if (!cbor) _paramsExportByte(&exp, ':');
+      _paramsExportValue(&exp, item);
     };
-    entry->max_value = (float*)esp_calloc(1, sizeof(float));
-    if (entry->max_value) {
-      *(float*)entry->max_value = max_value;
+    if (!first_entry) {
+      _paramsExportByte(&exp, cbor ? 0xFF : '}');
     };
   };
+  _paramsExportByte(&exp, cbor ? 0xFF : '}');
+  _paramsExportFlush(&exp);
+  return exp.ok;
 }
 
-void paramsSetLimitsDouble(paramsEntryHandle_t entry, double min_value, double max_value)
+typedef struct {
+  char* data;
+  size_t size;
+  size_t capacity;
+} paramsExportText_t;
+
+// MQTT message must be passed entirely, so the writer collects the document in the heap
+static bool _paramsMqttExportWriter(const uint8_t* data, size_t size, void* ctx)
 {
-  if (entry) {
-    entry->min_value = (double*)esp_calloc(1, sizeof(double));
-    if (entry->min_value) {
-      *(double*)entry->min_value = min_value;
-    };
-    entry->max_value = (double*)esp_calloc(1, sizeof(double));
-    if (entry->max_value) {
-      *(double*)entry->max_value = max_value;
+  paramsExportText_t* text = (paramsExportText_t*)ctx;
+  if (text->size + size + 1 > text->capacity) {
+    size_t capacity = text->capacity > 0 ? text->capacity * 2 : 1024;
+    while (text->size + size + 1 > capacity) capacity *= 2;
+    char* buf = (char*)realloc(text->data, capacity);
+    if (buf == nullptr) return false;
+    text->data = buf;
+    text->capacity = capacity;
+  };
+  memcpy(text->data + text->size, data, size);
+  text->size += size;
+  text->data[text->size] = '\0';
+  return true;
+}
+
+bool paramsMqttExport()
+{
+  if (!mqttIsConnected()) {
+    return false;
+  };
+  paramsExportText_t text = { nullptr, 0, 0 };
+  if (paramsExport(_paramsMqttExportWriter, &text, PARAMS_EXPORT_JSON) && (text.data)) {
+    char* topic = mqttGetTopicDevice(_paramsMqttPrimary, CONFIG_MQTT_ROOT_PARAMS_LOCAL, CONFIG_MQTT_ROOT_CONFIRM_TOPIC, CONFIG_PARAMS_MQTT_EXPORT_KEY, nullptr);
+    if (topic) {
+      rlog_i(logTAG, "Export of parameters (%d bytes) published to [ %s ]", (int)text.size, topic);
+      return mqttPublish(topic, text.data, CONFIG_MQTT_PARAMS_QOS, false, true, true);
     };
   };
+  rlog_e(logTAG, "Failed to export parameters!");
+  if (text.data) free(text.data);
+  return false;
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -854,9 +2933,14 @@ void paramsExecCmd(char *topic, char *payload)
 
     // Built-in command: reload controller
     if (strcasecmp(payload, CONFIG_MQTT_CMD_REBOOT) == 0) {
+      paramsFlush();
       msTaskDelay(3000);
       espRestart(RR_COMMAND_RESET);
     } 
+    // Built-in command: publish the export of all parameters
+    else if (strcasecmp(payload, CONFIG_MQTT_CMD_PARAMS_EXPORT) == 0) {
+      paramsMqttExport();
+    }
     // Custom commands
     else {
       // Send a command to the main loop for custom processing
@@ -877,16 +2961,17 @@ void paramsProcessSignal(paramsEntryHandle_t item, char *payload)
     rlog_i(logTAG, "Received signal [ %s ] in topic \"%s\"", payload, item->topic_subscribe);
     
     // Post event and call change handler
-    if (item->type_handler > PARAM_HANDLER_NONE) {
-      if (item->id > 0) {
-        eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_CHANGED, &item->id, sizeof(item->id), portMAX_DELAY);
+    if (item->meta->type_handler > PARAM_HANDLER_NONE) {
+      uint32_t id = _paramsEntryId(item);
+      if (id > 0) {
+        eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_CHANGED, &id, sizeof(id), portMAX_DELAY);
       };
-      if (item->handler) {
-        if (item->type_handler == PARAM_HANDLER_CLASS) {
-          param_handler_t* hdr = (param_handler_t*)item->handler;
+      if (item->meta->handler) {
+        if (item->meta->type_handler == PARAM_HANDLER_CLASS) {
+          param_handler_t* hdr = (param_handler_t*)item->meta->handler;
           hdr->onChange(PARAM_SET_CHANGED);
-        } else if (item->type_handler == PARAM_HANDLER_CALLBACK) {
-          params_callback_t cbf = (params_callback_t)item->handler;
+        } else if (item->meta->type_handler == PARAM_HANDLER_CALLBACK) {
+          params_callback_t cbf = (params_callback_t)item->meta->handler;
           cbf(item, PARAM_SET_CHANGED, payload);
         };
       };
@@ -896,9 +2981,9 @@ void paramsProcessSignal(paramsEntryHandle_t item, char *payload)
     if (item->type_param == OPT_KIND_SIGNAL_AUTOCLR) {
       mqttUnsubscribe(item->topic_subscribe);
       vTaskDelay(1);
-      mqttPublish(item->topic_subscribe, nullptr, item->qos, false, false, false);
+      mqttPublish(item->topic_subscribe, nullptr, item->meta->qos, false, false, false);
       vTaskDelay(1);
-      mqttSubscribe(item->topic_subscribe, item->qos);
+      mqttSubscribe(item->topic_subscribe, item->meta->qos);
     };
   };
 }
@@ -909,161 +2994,428 @@ void paramsProcessSignal(paramsEntryHandle_t item, char *payload)
 
 #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
 
-void paramsTelegramNotify(paramsEntryHandle_t entry, msg_priority_t priority, bool notify, const char* notify_template, char* value)
+#if CONFIG_PARAMS_TELEGRAM_DIGEST
+
+// Notification waiting for the digest: the new value is copied as text, the previous one is formatted by the timer
+typedef struct {
+  paramsEntryHandle_t entry;
+  params_notify_kind_t kind;
+  bool has_prev;
+  paramsValue_t prev;
+  char value[CONFIG_PARAMS_FORMAT_BUFFER_SIZE];
+} paramsDigestItem_t;
+
+// Space at the end of the digest for the number of skipped notifications
+#define PARAMS_DIGEST_RESERVE 32
+
+static bool _paramsDigestTimerCreate()
+{
+  if (!paramsWorkerTask) {
+    rlog_w(logTAG, "No worker task for notification digest, notifications will be sent immediately");
+    return false;
+  };
+  paramsDigestQueue = xQueueCreate(CONFIG_PARAMS_TELEGRAM_DIGEST_LIMIT, sizeof(paramsDigestItem_t));
+  if (paramsDigestQueue) {
+    paramsDigestTimer = xTimerCreate("params_tg", pdMS_TO_TICKS(CONFIG_PARAMS_TELEGRAM_DIGEST_WINDOW), pdFALSE, nullptr, paramsDigestTimerCallback);
+    if (paramsDigestTimer) {
+      return true;
+    };
+    vQueueDelete(paramsDigestQueue);
+    paramsDigestQueue = nullptr;
+  };
+  rlog_w(logTAG, "Failed to create timer for notification digest, notifications will be sent immediately");
+  return false;
+}
+
+static void _paramsDigestTimerDelete()
+{
+  if (paramsDigestTimer) {
+    xTimerDelete(paramsDigestTimer, portMAX_DELAY);
+    paramsDigestTimer = nullptr;
+  };
+  if (paramsDigestQueue) {
+    vQueueDelete(paramsDigestQueue);
+    paramsDigestQueue = nullptr;
+  };
+}
+
+// Called under the lock of the group: only copy the data, the message is created by the timer
+static void _paramsDigestAdd(paramsEntryHandle_t entry, params_notify_kind_t kind, char* value, const void* prev)
+{
+  paramsDigestItem_t item;
+  item.entry = entry;
+  item.kind = kind;
+  item.has_prev = prev != nullptr;
+  if (prev) {
+    memcpy(&item.prev, prev, _paramsValueSize(entry->type_value));
+  };
+  strncpy(item.value, value ? value : "", sizeof(item.value) - 1);
+  item.value[sizeof(item.value) - 1] = 0;
+  if (xQueueSend(paramsDigestQueue, &item, 0) != pdPASS) {
+    __atomic_fetch_add(&_paramsDigestDropped, 1, __ATOMIC_RELAXED);
+  };
+  if (xTimerIsTimerActive(paramsDigestTimer) == pdFALSE) {
+    xTimerStart(paramsDigestTimer, 0);
+  };
+}
+
+// Append one line "group / parameter (group.key): old → new" to the digest, returns false if it does not fit
+static bool _paramsDigestLine(char* msg, size_t* len, paramsDigestItem_t* item)
+{
+  static const char* suffix[] = { "", " (unchanged)", " (rejected)", " (bad value)" };
+  paramsEntryHandle_t entry = item->entry;
+  paramsValueText_t text;
+  char* prev = item->has_prev ? _paramsValueFormatFrom(entry, &item->prev, &text) : nullptr;
+  size_t size = CONFIG_PARAMS_TELEGRAM_DIGEST_SIZE - PARAMS_DIGEST_RESERVE - *len;
+  int ret = snprintf(msg + *len, size, "<i>%s</i> / %s (<code>%s.%s</code>): %s%s%s%s\n", 
+    ((entry->group) && (entry->group->friendly)) ? entry->group->friendly : "", 
+    entry->meta->friendly ? entry->meta->friendly : "",
+    ((entry->group) && (entry->group->key)) ? entry->group->key : CONFIG_MQTT_COMMON_TOPIC, 
+    entry->key, prev ? prev : "", prev ? " → " : "", item->value, suffix[item->kind]);
+  _paramsValueTextFree(&text);
+  if ((ret < 0) || ((size_t)ret >= size)) {
+    msg[*len] = 0;
+    return false;
+  };
+  *len += ret;
+  return true;
+}
+
+// Formatting and sending of the message are not performed in the timer service task, 
+// the timer only wakes up the worker task
+static void paramsDigestTimerCallback(TimerHandle_t timer)
+{
+  if (paramsWorkerTask) {
+    xTaskNotify(paramsWorkerTask, PARAMS_WORK_DIGEST, eSetBits);
+  };
+}
+
+// All notifications of the window are sent with one message, formatting is done here outside of any locks 
+// (called by the worker task)
+static void _paramsDigestSend()
 {
+  char* msg = (char*)esp_malloc(CONFIG_PARAMS_TELEGRAM_DIGEST_SIZE);
+  if (msg == nullptr) {
+    if (paramsDigestTimer) {
+      xTimerStart(paramsDigestTimer, 0);
+    };
+    return;
+  };
+  msg[0] = 0;
+  size_t len = 0;
+  uint32_t skipped = 0;
+  paramsDigestItem_t item;
+  while (xQueueReceive(paramsDigestQueue, &item, 0) == pdPASS) {
+    if (!_paramsDigestLine(msg, &len, &item)) skipped++;
+  };
+  skipped += __atomic_exchange_n(&_paramsDigestDropped, 0, __ATOMIC_RELAXED);
+  if (skipped > 0) {
+    snprintf(msg + len, CONFIG_PARAMS_TELEGRAM_DIGEST_SIZE - len, "... and %" PRIu32 " more", skipped);
+  };
+  if (msg[0]) {
+    tgSendMsg(encMsgOptions(MK_PARAMS, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY), 
+      CONFIG_TELEGRAM_DEVICE, CONFIG_MESSAGE_TG_PARAM_DIGEST, msg);
+  };
+  free(msg);
+}
+
+#endif // CONFIG_PARAMS_TELEGRAM_DIGEST
+
+// prev is the previous value of the parameter, if it is known (used only in the digest)
+void paramsTelegramNotify(paramsEntryHandle_t entry, params_notify_kind_t kind, char* value, const void* prev)
+{
+  #if CONFIG_PARAMS_TELEGRAM_DIGEST
+    if (paramsDigestTimer) {
+      _paramsDigestAdd(entry, kind, value, prev);
+      return;
+    };
+  #endif // CONFIG_PARAMS_TELEGRAM_DIGEST
+  const char* notify_template;
+  switch (kind) {
+    case PARAMS_NOTIFY_CHANGED: notify_template = CONFIG_MESSAGE_TG_PARAM_CHANGE; break;
+    case PARAMS_NOTIFY_EQUAL:   notify_template = CONFIG_MESSAGE_TG_PARAM_EQUAL; break;
+    case PARAMS_NOTIFY_INVALID: notify_template = CONFIG_MESSAGE_TG_PARAM_INVALID; break;
+    default:                    notify_template = CONFIG_MESSAGE_TG_PARAM_BAD; break;
+  };
+  msg_priority_t priority = CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY;
+  bool notify = CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED;
   if (value) {
     if ((entry->group) && (entry->group->friendly) && (entry->group->key)) {
       tgSendMsg(encMsgOptions(MK_PARAMS, notify, priority), CONFIG_TELEGRAM_DEVICE, 
-        notify_template, entry->group->friendly, entry->friendly, entry->group->key, entry->key, value);
+        notify_template, entry->group->friendly, entry->meta->friendly, entry->group->key, entry->key, value);
     } else {
       tgSendMsg(encMsgOptions(MK_PARAMS, notify, priority), CONFIG_TELEGRAM_DEVICE, 
-        notify_template, "", entry->friendly, CONFIG_MQTT_COMMON_TOPIC, entry->key, value);
+        notify_template, "", entry->meta->friendly, CONFIG_MQTT_COMMON_TOPIC, entry->key, value);
     };
   } else {
     if ((entry->group) && (entry->group->friendly) && (entry->group->key)) {
       tgSendMsg(encMsgOptions(MK_PARAMS, notify, priority), CONFIG_TELEGRAM_DEVICE, 
-        notify_template, entry->group->friendly, entry->friendly, entry->group->key, entry->key, "");
+        notify_template, entry->group->friendly, entry->meta->friendly, entry->group->key, entry->key, "");
     } else {
       tgSendMsg(encMsgOptions(MK_PARAMS, notify, priority), CONFIG_TELEGRAM_DEVICE, 
-        notify_template, "", entry->friendly, CONFIG_MQTT_COMMON_TOPIC, entry->key, "");
+        notify_template, "", entry->meta->friendly, CONFIG_MQTT_COMMON_TOPIC, entry->key, "");
     };
   };
 }
-#endif // CONFIG_TELEGRAM_ENABLE && CONFIG_TELEGRAM_PARAM_CHANGE_NOTIFY
+#endif // CONFIG_TELEGRAM_ENABLE && CONFIG_TELEGRAM_PARAM_CHANGE_NOTIFY
+
+// The calling task has an open transaction (see paramsBeginUpdate())
+static inline bool _paramsUpdateOwner()
+{
+  return (_paramsUpdateDepth > 0) && (_paramsUpdateTask == xTaskGetCurrentTaskHandle());
+}
+
+static paramsUpdateSaved_t* _paramsUpdateFindSaved(paramsEntryHandle_t entry)
+{
+  paramsUpdateSaved_t* saved = _paramsUpdateSaved;
+  while ((saved) && (saved->entry != entry)) {
+    saved = saved->next;
+  };
+  return saved;
+}
+
+// Remember the value before the first change in the transaction (the caller holds the lock of the group). 
+// The list belongs to the task that owns the transaction, so it is not protected by any lock
+static void _paramsUpdateSave(paramsEntryHandle_t entry, size_t size)
+{
+  if (_paramsUpdateFindSaved(entry)) return;
+  paramsUpdateSaved_t* saved = (paramsUpdateSaved_t*)esp_malloc(sizeof(paramsUpdateSaved_t));
+  if (saved) {
+    saved->entry = entry;
+    memcpy(&saved->value, entry->value, size);
+    saved->next = _paramsUpdateSaved;
+    _paramsUpdateSaved = saved;
+  } else {
+    rlog_w(logTAG, "Failed to save the previous value of parameter \"%s\", it will be restored from NVS", entry->key);
+  };
+}
+
+static void _paramsUpdateFreeSaved()
+{
+  while (_paramsUpdateSaved) {
+    paramsUpdateSaved_t* saved = _paramsUpdateSaved;
+    _paramsUpdateSaved = saved->next;
+    free(saved);
+  };
+}
+
+// Call the handler, publish the saved value and send notification (the caller holds the lock of the group)
+static void _paramsValueStoreNotify(paramsEntryHandle_t entry, const bool callHandler)
+{
+  // Post event and call change handler
+  if (callHandler) {
+    _paramsNotify(entry, PARAM_SET_INTERNAL);
+  };
+  // Publish the current value (formatted once for MQTT and notification)
+  paramsValueText_t text;
+  char* str_value = _paramsValueFormat(entry, &text);
+  _paramsMqttPublish(entry, true, str_value);
+  // Send notification
+  if (entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) 
+                     || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
+                     || (entry->type_param == OPT_KIND_PARAMETER_LOCATION))) {
+    // Send notification to telegram
+    #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+      if (str_value) {
+        paramsTelegramNotify(entry, PARAMS_NOTIFY_CHANGED, str_value, nullptr);
+      };
+    #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+  };
+  _paramsValueTextFree(&text);
+}
 
-void paramsValueStore(paramsEntryHandle_t entry, const bool callHandler)
+// The caller holds the lock of the group
+static void _paramsValueStore(paramsEntryHandle_t entry, const bool callHandler)
 {
-  OPTIONS_LOCK();
-  if (entry) {
-    if ((entry->type_param != OPT_KIND_COMMAND) && (entry->type_param != OPT_KIND_OTA)
-      && (entry->type_param != OPT_KIND_SIGNAL) && (entry->type_param != OPT_KIND_SIGNAL_AUTOCLR)) {
-      // Save the value in the storage
-      if (((entry->type_param == OPT_KIND_PARAMETER) 
-        || (entry->type_param == OPT_KIND_PARAMETER_LOCATION) 
-        || (entry->type_param == OPT_KIND_LOCDATA_STORED)
-        || (entry->type_param == OPT_KIND_EXTDATA_STORED)) 
-      && (entry->group) && (entry->group->key)) 
-      {
-        nvsWrite(entry->group->key, entry->key, entry->type_value, entry->value);
-      };
-      // Post event and call change handler
+  if ((entry->type_param != OPT_KIND_COMMAND) && (entry->type_param != OPT_KIND_OTA)
+    && (entry->type_param != OPT_KIND_SIGNAL) && (entry->type_param != OPT_KIND_SIGNAL_AUTOCLR)) {
+    if (_paramsUpdateOwner()) {
+      // Everything else will be done when the transaction is committed
+      entry->update_pending = true;
       if (callHandler) {
-        if (entry->type_handler > PARAM_HANDLER_NONE) {
-          if (entry->id > 0) {
-            eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_INTERNAL, &entry->id, sizeof(entry->id), portMAX_DELAY);
-          };
-          if ((entry->type_handler = PARAM_HANDLER_CLASS) && (entry->handler)) {
-            param_handler_t* hdr = (param_handler_t*)entry->handler;
-            hdr->onChange(PARAM_SET_INTERNAL);
-          } else if ((entry->type_handler = PARAM_HANDLER_CALLBACK) && (entry->handler)) {
-            params_callback_t cbf = (params_callback_t)entry->handler;
-            cbf(entry, PARAM_SET_INTERNAL, entry->value);
-          };
-        };
-      };
-      // Publish the current value
-      paramsMqttPublish(entry, true);
-      // Send notification
-      if (entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) 
-                         || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
-                         || (entry->type_param == OPT_KIND_PARAMETER_LOCATION))) {
-        // Send notification to telegram
-        #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
-          char* tg_value = value2string(entry->type_value, entry->value);
-          if (tg_value) {
-            paramsTelegramNotify(entry, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, 
-              CONFIG_MESSAGE_TG_PARAM_CHANGE, tg_value);
-            free(tg_value);
-          };
-        #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+        entry->update_handler = true;
       };
+    } else {
+      // Save the value in the storage
+      _paramsNvsStore(entry);
+      _paramsValueStoreNotify(entry, callHandler);
     };
   };
   #if CONFIG_SYSLED_MQTT_ACTIVITY
   ledSysActivity();
   #endif // CONFIG_SYSLED_MQTT_ACTIVITY
-  OPTIONS_UNLOCK();
 }
 
-void _paramsValueSet(paramsEntryHandle_t entry, char *value, bool publish_in_mqtt)
+void paramsValueStore(paramsEntryHandle_t entry, const bool callHandler)
+{
+  if (entry) {
+    ENTRY_LOCK(entry);
+    _paramsValueStore(entry, callHandler);
+    ENTRY_UNLOCK(entry);
+  };
+}
+
+bool paramsValueWrite(paramsEntryHandle_t entry, const void* value, size_t size, const bool callHandler)
+{
+  if ((entry) && (entry->value) && (value) && (size == _paramsValueSize(entry->type_value))) {
+    ENTRY_LOCK(entry);
+    // The first change in the transaction: keep the previous value to be able to abort it
+    if ((!entry->update_pending) && _paramsUpdateOwner()) {
+      _paramsUpdateSave(entry, size);
+    };
+    #if CONFIG_PARAMS_SUSPEND_SCHEDULER
+      vTaskSuspendAll();
+    #endif // CONFIG_PARAMS_SUSPEND_SCHEDULER
+    _paramsValueWriteBegin(entry);
+    memcpy(entry->value, value, size);
+    _paramsValueWriteEnd(entry);
+    #if CONFIG_PARAMS_SUSPEND_SCHEDULER
+      xTaskResumeAll();
+    #endif // CONFIG_PARAMS_SUSPEND_SCHEDULER
+    _paramsValueStore(entry, callHandler);
+    ENTRY_UNLOCK(entry);
+    return true;
+  };
+  return false;
+}
+
+// Result of setting a new value
+typedef enum {
+  PARAMS_SET_RESULT_CHANGED = 0,
+  PARAMS_SET_RESULT_EQUAL,
+  PARAMS_SET_RESULT_INVALID,
+  PARAMS_SET_RESULT_BAD
+} params_set_result_t;
+
+// In bulk mode the value is not written to NVS (the entry is marked as dirty), is not published and notifications 
+// are not sent: all this is done once for the whole group by the caller. If decoded is not nullptr, the value 
+// is already received in binary form and the text is used only for the log and notifications
+params_set_result_t _paramsValueSet(paramsEntryHandle_t entry, char *value, const paramsValue_t *decoded, bool publish_in_mqtt, bool bulk)
 {
+  params_set_result_t ret = PARAMS_SET_RESULT_BAD;
   rlog_i(logTAG, "Received new value [ %s ] for parameter \"%s.%s\"", value, entry->group->key, entry->key);
   
-  // Convert the resulting value to the target format
-  void *new_value = string2value(entry->type_value, value);
+  // Convert the resulting value to the target format: strings are compared with the payload as is, 
+  // numbers are parsed into a local variable, and only unusual formats are passed to string2value().
+  // Typed parameters use only the functions for their type
+  const paramsValueOps_t *ops = entry->meta->ops;
+  paramsValue_t parsed;
+  void *heap_value = nullptr;
+  void *new_value = nullptr;
+  if (decoded) {
+    parsed = *decoded;
+    new_value = &parsed;
+  } else if (ops) {
+    if (ops->parse(value, &parsed)) {
+      new_value = &parsed;
+    };
+  } else if (entry->type_value == OPT_TYPE_STRING) {
+    new_value = value;
+  } else if (_paramsValueParse(entry->type_value, value, &parsed)) {
+    new_value = &parsed;
+  } else {
+    heap_value = string2value(entry->type_value, value);
+    new_value = heap_value;
+  };
   if (new_value) {
     // If the new value is different from what is already written in the variable...
-    if (equal2value(entry->type_value, entry->value, new_value)) {
+    bool is_equal;
+    if (ops) {
+      is_equal = ops->equal(entry->value, new_value);
+    } else if (entry->type_value == OPT_TYPE_STRING) {
+      is_equal = (entry->value) && (strcmp((char*)entry->value, value) == 0);
+    } else {
+      is_equal = equal2value(entry->type_value, entry->value, new_value);
+    };
+    if (is_equal) {
+      ret = PARAMS_SET_RESULT_EQUAL;
       rlog_i(logTAG, "Received value does not differ from existing one, ignored");
       // Post event
-      if ((entry->type_handler > PARAM_HANDLER_NONE) && (entry->id > 0)) {
-        eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_EQUALS, &entry->id, sizeof(entry->id), portMAX_DELAY);
+      uint32_t id = _paramsEntryId(entry);
+      if ((entry->meta->type_handler > PARAM_HANDLER_NONE) && (id > 0)) {
+        eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_EQUALS, &id, sizeof(id), portMAX_DELAY);
       };
       // Publish value
-      paramsMqttPublish(entry, publish_in_mqtt);
+      if (!bulk) {
+        paramsMqttPublish(entry, publish_in_mqtt);
+      };
       // Send notification
-      if (entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE))) {
+      if (!bulk && entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE))) {
         // Send notification to telegram
         #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
-          paramsTelegramNotify(entry, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, 
-            CONFIG_MESSAGE_TG_PARAM_EQUAL, value);
+          paramsTelegramNotify(entry, PARAMS_NOTIFY_EQUAL, value, nullptr);
         #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
       };
     } else {
       // Check the new value and possibly correct it to be valid
-      if (valueCheckLimits(entry->type_value, new_value, entry->min_value, entry->max_value)) {
+      bool is_valid;
+      if (ops) {
+        is_valid = !entry->meta->has_limits || ops->check(new_value, &entry->meta->min_value, &entry->meta->max_value);
+      } else {
+        paramsValue_t min_value = entry->meta->min_value;
+        paramsValue_t max_value = entry->meta->max_value;
+        is_valid = valueCheckLimits(entry->type_value, new_value, 
+          entry->meta->has_limits ? &min_value : nullptr, entry->meta->has_limits ? &max_value : nullptr);
+      };
+      if (is_valid) {
+        ret = PARAMS_SET_RESULT_CHANGED;
         // Block context switching to other tasks to prevent reading the value while it is changing
-        vTaskSuspendAll();
+        #if CONFIG_PARAMS_SUSPEND_SCHEDULER
+          vTaskSuspendAll();
+        #endif // CONFIG_PARAMS_SUSPEND_SCHEDULER
+        // Previous value for the notification
+        paramsValue_t prev_value;
+        size_t prev_size = _paramsValueSize(entry->type_value);
+        if (prev_size > 0) {
+          memcpy(&prev_value, entry->value, prev_size);
+        };
         // Set the new value to the variable
-        setNewValue(entry->type_value, entry->value, new_value);
+        _paramsValueWriteBegin(entry);
+        if (ops) {
+          ops->assign(entry->value, new_value);
+        } else {
+          setNewValue(entry->type_value, entry->value, new_value);
+        };
+        _paramsValueWriteEnd(entry);
         // Restoring the scheduler
-        xTaskResumeAll();
+        #if CONFIG_PARAMS_SUSPEND_SCHEDULER
+          xTaskResumeAll();
+        #endif // CONFIG_PARAMS_SUSPEND_SCHEDULER
         // Save the value in the storage
-        if (((entry->type_param == OPT_KIND_PARAMETER) 
-          || (entry->type_param == OPT_KIND_PARAMETER_LOCATION) 
-          || (entry->type_param == OPT_KIND_LOCDATA_STORED)
-          || (entry->type_param == OPT_KIND_EXTDATA_STORED)) 
-         && (entry->group) && (entry->group->key)) 
-        {
-          nvsWrite(entry->group->key, entry->key, entry->type_value, entry->value);
+        if (!bulk) {
+          _paramsNvsStore(entry);
+        } else if (_paramsIsStored(entry)) {
+          entry->dirty = true;
         };
         // Post event and call change handler
-        if (entry->type_handler > PARAM_HANDLER_NONE) {
-          if (entry->id > 0) {
-            eventLoopPost(RE_PARAMS_EVENTS, RE_PARAMS_CHANGED, &entry->id, sizeof(entry->id), portMAX_DELAY);
-          };
-          if ((entry->type_handler = PARAM_HANDLER_CLASS) && (entry->handler)) {
-            param_handler_t* hdr = (param_handler_t*)entry->handler;
-            hdr->onChange(PARAM_SET_CHANGED);
-          } else if ((entry->type_handler = PARAM_HANDLER_CALLBACK) && (entry->handler)) {
-            params_callback_t cbf = (params_callback_t)entry->handler;
-            cbf(entry, PARAM_SET_CHANGED, entry->value);
-          };
-        };
+        _paramsNotify(entry, PARAM_SET_CHANGED);
         // Only for parameters...
-        paramsMqttPublish(entry, publish_in_mqtt);
+        if (!bulk) {
+          paramsMqttPublish(entry, publish_in_mqtt);
+        };
         // Send notification
-        if (entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) 
+        if (!bulk && entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) 
                            || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
                            || (entry->type_param == OPT_KIND_PARAMETER_LOCATION))) {
           // Send notification to telegram
           #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
-            paramsTelegramNotify(entry, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, 
-              CONFIG_MESSAGE_TG_PARAM_CHANGE, value);
+            paramsTelegramNotify(entry, PARAMS_NOTIFY_CHANGED, value, prev_size > 0 ? &prev_value : nullptr);
           #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
         };
       } else {
+        ret = PARAMS_SET_RESULT_INVALID;
         rlog_w(logTAG, "Received value [ %s ] is out of range, ignored!", value);
         // Only for parameters...
-        paramsMqttPublish(entry, publish_in_mqtt);
+        if (!bulk) {
+          paramsMqttPublish(entry, publish_in_mqtt);
+        };
         // Send notification
-        if (entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) 
+        if (!bulk && entry->notify && ((entry->type_param == OPT_KIND_PARAMETER) 
                            || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
                            || (entry->type_param == OPT_KIND_PARAMETER_LOCATION))) {
           // Send notification to telegram
           #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
-            paramsTelegramNotify(entry, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, 
-              CONFIG_MESSAGE_TG_PARAM_INVALID, value);
+            paramsTelegramNotify(entry, PARAMS_NOTIFY_INVALID, value, nullptr);
           #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
         };
       };
@@ -1071,23 +3423,23 @@ void _paramsValueSet(paramsEntryHandle_t entry, char *value, bool publish_in_mqt
   } else {
     rlog_e(logTAG, "Could not convert value [ %s ]!", value);
     // Send notification
-    if ((entry->type_param == OPT_KIND_PARAMETER) 
-     || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
-     || (entry->type_param == OPT_KIND_PARAMETER_LOCATION)) {
+    if (!bulk && ((entry->type_param == OPT_KIND_PARAMETER) 
+               || (entry->type_param == OPT_KIND_PARAMETER_ONLINE) 
+               || (entry->type_param == OPT_KIND_PARAMETER_LOCATION))) {
       // Send notification to telegram
       #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
-        paramsTelegramNotify(entry, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, 
-          CONFIG_MESSAGE_TG_PARAM_BAD, value);
+        paramsTelegramNotify(entry, PARAMS_NOTIFY_BAD, value, nullptr);
       #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
     };
   };
-  if (new_value) free(new_value);
+  if (heap_value) free(heap_value);
+  return ret;
 }
 
 void paramsValueSet(paramsEntryHandle_t entry, char *new_value, bool publish_in_mqtt)
 {
-  OPTIONS_LOCK();
   if (entry) {
+    ENTRY_LOCK(entry);
     if ((entry->type_param == OPT_KIND_PARAMETER) 
      || (entry->type_param == OPT_KIND_PARAMETER_ONLINE)
      || (entry->type_param == OPT_KIND_PARAMETER_LOCATION) 
@@ -1096,175 +3448,606 @@ void paramsValueSet(paramsEntryHandle_t entry, char *new_value, bool publish_in_
      || (entry->type_param == OPT_KIND_EXTDATA_ONLINE) 
      || (entry->type_param == OPT_KIND_EXTDATA_STORED))) 
     {
-      _paramsValueSet(entry, new_value, publish_in_mqtt);
+      _paramsValueSet(entry, new_value, nullptr, publish_in_mqtt, false);
     };
+    ENTRY_UNLOCK(entry);
   };
-  OPTIONS_UNLOCK();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- Update transactions -------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+void paramsBeginUpdate()
+{
+  if (paramsUpdateLock) {
+    if (_paramsUpdateOwner()) {
+      _paramsUpdateDepth++;
+      return;
+    };
+    xSemaphoreTake(paramsUpdateLock, portMAX_DELAY);
+    // NVS must contain the values at the start of the transaction, they are used to abort it
+    paramsFlush();
+    _paramsUpdateTask = xTaskGetCurrentTaskHandle();
+    _paramsUpdateAborted = false;
+    _paramsUpdateDepth = 1;
+  };
+}
+
+// Save the changed values of the group with one NVS commit, then call handlers and publish them 
+// (the caller holds the lock of the group)
+static void _paramsUpdateCommitGroup(paramsEntryHandle_t first)
+{
+  paramsGroupHandle_t group = first->group;
+  bool stored = false;
+  paramsEntryHandle_t item = first;
+  while (item) {
+    if ((item->update_pending) && (item->group == group) && _paramsIsStored(item)) {
+      item->dirty = true;
+      stored = true;
+    };
+    item = STAILQ_NEXT(item, next);
+  };
+  if (stored) {
+    _paramsNvsStoreGroup(group);
+  };
+  item = first;
+  while (item) {
+    if ((item->update_pending) && (item->group == group)) {
+      bool handler = item->update_handler;
+      item->update_pending = false;
+      item->update_handler = false;
+      _paramsValueStoreNotify(item, handler);
+    };
+    item = STAILQ_NEXT(item, next);
+  };
+}
+
+// Restore the values of the group saved before their first change in the transaction. If the value was changed 
+// directly in the variable and is not saved, it is read from NVS (the transaction starts with writing all pending 
+// changes to NVS). Values that cannot be restored are committed, so that the variable, NVS and the broker do not 
+// diverge. Returns false in this case (the caller holds the lock of the group)
+static bool _paramsUpdateAbortGroup(paramsEntryHandle_t first)
+{
+  paramsGroupHandle_t group = first->group;
+  bool ret = true;
+  bool opened = false;
+  nvs_handle_t nvs_handle;
+  paramsEntryHandle_t item = first;
+  while (item) {
+    if ((item->update_pending) && (item->group == group)) {
+      paramsUpdateSaved_t* saved = _paramsUpdateFindSaved(item);
+      bool restored = false;
+      if (saved) {
+        _paramsValueWriteBegin(item);
+        memcpy(item->value, &saved->value, _paramsValueSize(item->type_value));
+        _paramsValueWriteEnd(item);
+        restored = true;
+      } else if (_paramsIsStored(item)) {
+        if (!opened) {
+          opened = nvs_open(group->key, NVS_READONLY, &nvs_handle) == ESP_OK;
+        };
+        restored = (opened) && _paramsNvsReadItem(nvs_handle, item);
+      };
+      if (restored) {
+        item->update_pending = false;
+        item->update_handler = false;
+      } else {
+        rlog_e(logTAG, "Failed to restore the previous value of parameter \"%s\", the change is committed", item->key);
+        ret = false;
+      };
+    };
+    item = STAILQ_NEXT(item, next);
+  };
+  if (opened) {
+    nvs_close(nvs_handle);
+  };
+  _paramsUpdateCommitGroup(first);
+  return ret;
+}
+
+// Returns true if the changes were committed (when committing) or all of them were restored (when aborting)
+static bool _paramsUpdateEnd(bool abort)
+{
+  if (!_paramsUpdateOwner()) return false;
+  if (abort) {
+    _paramsUpdateAborted = true;
+  };
+  if (--_paramsUpdateDepth > 0) {
+    // Only the outer transaction is committed or aborted
+    return abort || !_paramsUpdateAborted;
+  };
+  bool commit = !_paramsUpdateAborted;
+  bool restored = true;
+  // From here paramsValueStore() works as usual, also in the handlers called by the commit
+  _paramsUpdateTask = nullptr;
+  // The list of parameters is append-only, so it can be walked without paramsLock
+  if (paramsList) {
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      if (item->update_pending) {
+        ENTRY_LOCK(item);
+        if (commit) {
+          _paramsUpdateCommitGroup(item);
+        } else if (!_paramsUpdateAbortGroup(item)) {
+          restored = false;
+        };
+        ENTRY_UNLOCK(item);
+      };
+    };
+  };
+  _paramsUpdateFreeSaved();
+  xSemaphoreGive(paramsUpdateLock);
+  return abort ? restored : commit;
+}
+
+bool paramsCommitUpdate()
+{
+  return _paramsUpdateEnd(false);
+}
+
+bool paramsAbortUpdate()
+{
+  return _paramsUpdateEnd(true);
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
 // ------------------------------------------------ MQTT public functions ------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-void paramsMqttIncomingMessage(char *topic, char *payload, size_t len)
+static paramsEntryHandle_t _paramsMqttFindEntry(const char* topic)
 {
-  if ((topic) && (payload)) {
+  paramsEntryHandle_t item = nullptr;
+  INDEX_LOCK();
+  #if CONFIG_MQTT_PARAMS_WILDCARD
+    // Wildcard parameters: cut "%LOCATION% / %DEVICE% / CONFIG /" and search by "group_topic/key"
+    if ((_paramsWildcardPrefixLen > 0) && (strncasecmp(topic, _paramsWildcardTopic, _paramsWildcardPrefixLen) == 0)) {
+      item = _paramsTopicIndexFindRoute(topic + _paramsWildcardPrefixLen);
+    };
+    if (item == nullptr) {
+      item = _paramsTopicIndexFind(topic);
+    };
+  #else
+    item = _paramsTopicIndexFind(topic);
+  #endif // CONFIG_MQTT_PARAMS_WILDCARD
+  INDEX_UNLOCK();
+  return item;
+}
+
+#if CONFIG_PARAMS_MQTT_BULK
+
+// The list of groups is append-only, bulk topics of a group are created and released under the lock of the group
+static paramsGroupHandle_t _paramsMqttFindBulk(const char* topic)
+{
+  if (paramsGroups) {
+    paramsGroupHandle_t group;
+    STAILQ_FOREACH(group, paramsGroups, next) {
+      GROUP_LOCK(group);
+      bool found = (group->topic_bulk) && (strcasecmp(group->topic_bulk, topic) == 0);
+      GROUP_UNLOCK(group);
+      if (found) {
+        return group;
+      };
+    };
+  };
+  return nullptr;
+}
+
+// Text of the JSON value for _paramsValueSet(): strings as is, booleans as 0 / 1, numbers as printed by cJSON
+static char* _paramsMqttBulkValue(cJSON* item, char** heap)
+{
+  *heap = nullptr;
+  if (cJSON_IsString(item)) {
+    return item->valuestring;
+  } else if (cJSON_IsBool(item)) {
+    return (char*)(cJSON_IsTrue(item) ? "1" : "0");
+  } else if (cJSON_IsNumber(item)) {
+    *heap = cJSON_PrintUnformatted(item);
+    return *heap;
+  };
+  return nullptr;
+}
+
+// All values of the message are applied under one lock of the group, the changed values are written to NVS 
+// with one commit and the current values of all parameters of the message are confirmed with one JSON message
+static void _paramsMqttBulkSet(paramsGroupHandle_t group, const char* payload, size_t len)
+{
+  cJSON* json = cJSON_ParseWithLength(payload, len);
+  if (!cJSON_IsObject(json)) {
+    rlog_e(logTAG, "Bulk message for group \"%s\" is not a JSON object!", group->key);
+    cJSON_Delete(json);
+    return;
+  };
+
+  int count = cJSON_GetArraySize(json);
+  paramsEntryHandle_t* entries = count > 0 ? (paramsEntryHandle_t*)esp_calloc(count, sizeof(paramsEntryHandle_t)) : nullptr;
+  if (entries) {
+    cJSON* item;
+    int i = 0;
+    // The key index is changed only under paramsLock, but handlers must be called without it
     OPTIONS_LOCK();
+    cJSON_ArrayForEach(item, json) {
+      entries[i++] = item->string ? _paramsKeyIndexFind(group, item->string) : nullptr;
+    };
+    OPTIONS_UNLOCK();
 
-    if (paramsList) {
-      paramsEntryHandle_t item;
-      STAILQ_FOREACH(item, paramsList, next) {
-        if (item->topic_subscribe == nullptr) {
-          uint8_t tryCnt = 0;
-          do {
-            tryCnt++;
-            paramsMqttTopicsCreateEntry(item);
-            if (item->topic_subscribe == nullptr) vTaskDelay(10);
-          } while ((item->topic_subscribe == nullptr) && (tryCnt < 255));
+    uint16_t changed = 0;
+    uint16_t rejected = 0;
+    cJSON* confirm = cJSON_CreateObject();
+    GROUP_LOCK(group);
+    i = 0;
+    cJSON_ArrayForEach(item, json) {
+      paramsEntryHandle_t entry = entries[i++];
+      if ((entry) && ((entry->type_param == OPT_KIND_PARAMETER) || (entry->type_param == OPT_KIND_PARAMETER_ONLINE))) {
+        char* heap;
+        char* value = _paramsMqttBulkValue(item, &heap);
+        params_set_result_t result = PARAMS_SET_RESULT_BAD;
+        if (entry->locked) {
+          entry->locked = false;
+          rlog_v(logTAG, "Incoming value for locked parameter, ignored");
+        } else if (value) {
+          result = _paramsValueSet(entry, value, nullptr, false, true);
+        } else {
+          rlog_e(logTAG, "Unsupported value of parameter \"%s.%s\" in bulk message!", group->key, entry->key);
         };
-
-        if (item->topic_subscribe != nullptr) {
-          if (strcasecmp(item->topic_subscribe, topic) == 0) {
-            if (item->locked) {
-              item->locked = false;
-              rlog_v(logTAG, "Incoming value for locked parameter, ignored");
+        if (heap) free(heap);
+        if (result == PARAMS_SET_RESULT_CHANGED) {
+          changed++;
+        } else if (result != PARAMS_SET_RESULT_EQUAL) {
+          rejected++;
+        };
+        // Current value of the parameter
+        if (confirm) {
+          paramsValueText_t text;
+          char* str_value = _paramsValueFormat(entry, &text);
+          if (str_value) {
+            if (entry->type_value == OPT_TYPE_STRING) {
+              cJSON_AddStringToObject(confirm, entry->key, str_value);
             } else {
-              switch (item->type_param) {
-                case OPT_KIND_OTA:
-                  #if CONFIG_MQTT_OTA_ENABLE
-                  if (strcmp(payload, "") != 0) {
-                    paramsStartOTA(topic, payload);
-                  };
-                  #endif // CONFIG_MQTT_OTA_ENABLE
-                  break;
-                
-                case OPT_KIND_COMMAND:
-                  #if CONFIG_MQTT_COMMAND_ENABLE
-                  if (strcmp(payload, "") != 0) {
-                    paramsExecCmd(topic, payload);
-                  };
-                  #endif // CONFIG_MQTT_COMMAND_ENABLE
-                  break;
+              cJSON_AddRawToObject(confirm, entry->key, str_value);
+            };
+          };
+          _paramsValueTextFree(&text);
+        };
+      } else {
+        rlog_w(logTAG, "Parameter \"%s.%s\" from bulk message not found!", group->key, item->string ? item->string : "");
+        entries[i - 1] = nullptr;
+        rejected++;
+      };
+    };
+    // One commit for all changed values of the group
+    if (changed > 0) {
+      _paramsNvsStoreGroup(group);
+    };
+    // The topic can be released by reconnection as soon as the lock is released, a copy is published
+    char* confirm_topic = (confirm) && (group->topic_bulk_confirm) ? malloc_string(group->topic_bulk_confirm) : nullptr;
+    GROUP_UNLOCK(group);
 
-                case OPT_KIND_SIGNAL:
-                case OPT_KIND_SIGNAL_AUTOCLR:
-                  if (strcmp(payload, "") != 0) {
-                    paramsProcessSignal(item, payload);
-                  };
-                  break;
+    // Confirmation topics of the parameters are retained, so they are updated as after a single change. 
+    // The queue of pending values publishes them later and collapses repeated changes
+    for (i = 0; i < count; i++) {
+      if (entries[i]) {
+        #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+          if (paramsPublishTimer) {
+            _paramsMqttPublishDefer(entries[i], false);
+            continue;
+          };
+        #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+        ENTRY_LOCK(entries[i]);
+        paramsMqttPublish(entries[i], false);
+        ENTRY_UNLOCK(entries[i]);
+      };
+    };
+    free(entries);
 
-                case OPT_KIND_PARAMETER:
-                case OPT_KIND_PARAMETER_ONLINE:
-                case OPT_KIND_PARAMETER_LOCATION:
-                case OPT_KIND_LOCDATA_ONLINE:
-                case OPT_KIND_LOCDATA_STORED:
-                case OPT_KIND_EXTDATA_ONLINE:
-                case OPT_KIND_EXTDATA_STORED:
-                  _paramsValueSet(item, payload, false);
-                  break;
+    // One confirmation for the whole message, it is published after the lock is released. This is a JSON document 
+    // of the group, so it is not passed through the queue of pending values and does not use the binary mode
+    if (confirm) {
+      if (mqttIsConnected() && (confirm_topic)) {
+        char* confirm_json = cJSON_PrintUnformatted(confirm);
+        if (confirm_json) {
+          mqttPublish(confirm_topic, confirm_json, CONFIG_MQTT_PARAMS_QOS, false, true, true);
+          confirm_topic = nullptr;
+        };
+      };
+      cJSON_Delete(confirm);
+    };
+    if (confirm_topic) free(confirm_topic);
+
+    rlog_i(logTAG, "Bulk message for group \"%s\": %d changed, %d rejected", group->key, changed, rejected);
+    #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+      if ((changed > 0) || (rejected > 0)) {
+        tgSendMsg(encMsgOptions(MK_PARAMS, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY), 
+          CONFIG_TELEGRAM_DEVICE, CONFIG_MESSAGE_TG_PARAM_BULK, group->friendly ? group->friendly : "", group->key, changed, rejected);
+      };
+    #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+  };
+  cJSON_Delete(json);
+}
 
-                default:
+// Subscribe to the bulk topics of all groups (the wildcard topic already includes them). The caller holds paramsLock
+static void _paramsMqttBulkSubscribe()
+{
+  if (paramsGroups) {
+    paramsGroupHandle_t group;
+    STAILQ_FOREACH(group, paramsGroups, next) {
+      GROUP_LOCK(group);
+      _paramsMqttTopicsCreateGroup(group);
+      #if !CONFIG_MQTT_PARAMS_WILDCARD
+        if ((group->topic_bulk) && !group->bulk_subscribed && mqttIsConnected()) {
+          group->bulk_subscribed = mqttSubscribe(group->topic_bulk, CONFIG_MQTT_PARAMS_QOS);
+        };
+      #endif // CONFIG_MQTT_PARAMS_WILDCARD
+      GROUP_UNLOCK(group);
+    };
+  };
+}
+
+#endif // CONFIG_PARAMS_MQTT_BULK
+
+void paramsMqttIncomingMessage(char *topic, char *payload, size_t len)
+{
+  if ((topic) && (payload)) {
+    // Search for the parameter by topic in the index
+    paramsEntryHandle_t item = _paramsMqttFindEntry(topic);
+    if ((item == nullptr) && !_paramsTopicsComplete) {
+      // Some topics have not yet been generated, create them and try again
+      OPTIONS_LOCK();
+      _paramsMqttTopicsCreateMissing();
+      OPTIONS_UNLOCK();
+      item = _paramsMqttFindEntry(topic);
+    };
+
+    // Only the group of the parameter is locked, other groups can be changed at the same time
+    if (item) {
+      ENTRY_LOCK(item);
+      if (item->locked) {
+        item->locked = false;
+        rlog_v(logTAG, "Incoming value for locked parameter, ignored");
+      } else {
+        switch (item->type_param) {
+          case OPT_KIND_OTA:
+            #if CONFIG_MQTT_OTA_ENABLE
+            if (strcmp(payload, "") != 0) {
+              paramsStartOTA(topic, payload);
+            };
+            #endif // CONFIG_MQTT_OTA_ENABLE
+            break;
+          
+          case OPT_KIND_COMMAND:
+            #if CONFIG_MQTT_COMMAND_ENABLE
+            if (strcmp(payload, "") != 0) {
+              paramsExecCmd(topic, payload);
+            };
+            #endif // CONFIG_MQTT_COMMAND_ENABLE
+            break;
+
+          case OPT_KIND_SIGNAL:
+          case OPT_KIND_SIGNAL_AUTOCLR:
+            if (strcmp(payload, "") != 0) {
+              paramsProcessSignal(item, payload);
+            };
+            break;
+
+          case OPT_KIND_PARAMETER:
+          case OPT_KIND_PARAMETER_ONLINE:
+          case OPT_KIND_PARAMETER_LOCATION:
+          case OPT_KIND_LOCDATA_ONLINE:
+          case OPT_KIND_LOCDATA_STORED:
+          case OPT_KIND_EXTDATA_ONLINE:
+          case OPT_KIND_EXTDATA_STORED:
+            #if CONFIG_PARAMS_MQTT_BINARY
+              if (_paramsIsBinary(item)) {
+                paramsValue_t decoded;
+                if (_paramsValueDecode(item, payload, len, &decoded)) {
+                  _paramsValueSet(item, (char*)"(binary)", &decoded, false, false);
                   break;
+                };
               };
-            };
+            #endif // CONFIG_PARAMS_MQTT_BINARY
+            _paramsValueSet(item, payload, nullptr, false, false);
+            break;
 
-            OPTIONS_UNLOCK();
-            return;
-          };
+          default:
+            break;
         };
       };
+
+      ENTRY_UNLOCK(item);
+      return;
     };
 
+    // Bulk change of the parameters of a group
+    #if CONFIG_PARAMS_MQTT_BULK
+      paramsGroupHandle_t group = _paramsMqttFindBulk(topic);
+      if (group) {
+        _paramsMqttBulkSet(group, payload, len);
+        return;
+      };
+    #endif // CONFIG_PARAMS_MQTT_BULK
+
     rlog_w(logTAG, "MQTT message from topic [ %s ] was not processed!", topic);
     #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
       tgSend(MK_SERVICE, CONFIG_NOTIFY_TELEGRAM_PARAM_PRIORITY, CONFIG_NOTIFY_TELEGRAM_ALERT_PARAM_CHANGED, CONFIG_TELEGRAM_DEVICE, 
         CONFIG_MESSAGE_TG_MQTT_NOT_PROCESSED, topic, payload);
     #endif // CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED
+  };
+}
+
+// Subscription pass is performed in steps. Each step collects topics of the next unsubscribed parameters under 
+// paramsLock until one of the batches is full, then the batch is sent without paramsLock. The position in the list 
+// is kept between steps (the list is only appended until paramsFree). A new pass or closing subscriptions 
+// stop the current pass, parameters that were not subscribed will be subscribed by the next pass
+typedef enum {
+  PARAMS_PASS_CONTINUE = 0,
+  PARAMS_PASS_COMPLETED,
+  PARAMS_PASS_STOPPED
+} params_pass_state_t;
+
+static params_pass_state_t _paramsMqttResubscribeStep(uint32_t pass)
+{
+  paramsSubscribeBatch_t* full = nullptr;
+  bool completed = false;
+
+  // Preparing parameters may publish current values to confirmation topics
+  _paramsMqttOutboxWait();
 
+  OPTIONS_LOCK();
+  if ((pass != _paramsResubscribePass) || !mqttIsConnected()) {
     OPTIONS_UNLOCK();
+    return PARAMS_PASS_STOPPED;
+  };
+  while ((_paramsResubscribeNext) && (full == nullptr)) {
+    paramsEntryHandle_t item = _paramsResubscribeNext;
+    if (!item->subscribed) {
+      full = _paramsMqttBatchAdd(item);
+    };
+    _paramsResubscribeNext = STAILQ_NEXT(item, next);
+  };
+  completed = (_paramsResubscribeNext == nullptr);
+  OPTIONS_UNLOCK();
+
+  if ((full) && !_paramsMqttBatchFlush(full)) {
+    return PARAMS_PASS_STOPPED;
+  };
+  if (completed) {
+    for (uint8_t i = 0; i < 3; i++) {
+      if (!_paramsMqttBatchFlush(&_paramsSubscribeBatches[i])) {
+        return PARAMS_PASS_STOPPED;
+      };
+    };
+    return PARAMS_PASS_COMPLETED;
+  };
+  return PARAMS_PASS_CONTINUE;
+}
+
+// The caller holds paramsLock
+static void _paramsMqttResetSubscribed()
+{
+  if (paramsList) {
+    paramsEntryHandle_t item;
+    STAILQ_FOREACH(item, paramsList, next) {
+      ENTRY_LOCK(item);
+      item->subscribed = false;
+      ENTRY_UNLOCK(item);
+    };
   };
+  #if CONFIG_PARAMS_MQTT_BULK
+    if (paramsGroups) {
+      paramsGroupHandle_t group;
+      STAILQ_FOREACH(group, paramsGroups, next) {
+        GROUP_LOCK(group);
+        group->bulk_subscribed = false;
+        GROUP_UNLOCK(group);
+      };
+    };
+  #endif // CONFIG_PARAMS_MQTT_BULK
 }
 
 void paramsMqttSubscribesOpen(bool mqttPrimary, bool forcedResubscribe)
 {
-  if (mqttIsConnected()) {
+  if (mqttIsConnected() && (paramsList)) {
     rlog_i(logTAG, "Subscribing to parameter topics...");
 
+    uint32_t _identity = _paramsMqttTopicsIdentity(mqttPrimary);
+    // The previous pass (if any) stops at its next step
     OPTIONS_LOCK();
+    uint32_t _pass = ++_paramsResubscribePass;
+    OPTIONS_UNLOCK();
+    xSemaphoreTake(paramsSubscribeLock, portMAX_DELAY);
     #if CONFIG_SYSLED_MQTT_ACTIVITY
     ledSysOn(true);
     #endif // CONFIG_SYSLED_MQTT_ACTIVITY
 
-    bool _failed = false;
+    OPTIONS_LOCK();
     bool _resubscribe = forcedResubscribe || (_paramsMqttPrimary != mqttPrimary);
-    _paramsMqttPrimary = mqttPrimary;
+    // Regenerate topics only if they have changed, subscriptions to the previous topics are no longer valid
+    if ((_paramsMqttPrimary != mqttPrimary) || (_paramsMqttIdentity != _identity)) {
+      _paramsMqttTopicsReset(mqttPrimary, _identity);
+      _paramsMqttResetSubscribed();
+      #if CONFIG_MQTT_PARAMS_WILDCARD
+        paramsMqttFreeWildcard();
+      #endif // CONFIG_MQTT_PARAMS_WILDCARD
+      _resubscribe = true;
+    };
+    _paramsResubscribeNext = _resubscribe ? STAILQ_FIRST(paramsList) : nullptr;
+    OPTIONS_UNLOCK();
 
-    if (paramsList) {
-      paramsEntryHandle_t item;
-      STAILQ_FOREACH(item, paramsList, next) {
-        if (_resubscribe && !item->subscribed) {
-          uint8_t i = 0;
-          while (mqttIsConnected() && (i < 100) && (mqttGetOutboxSize() > 1024)) {
-            if (i == 0) { 
-              rlog_v(logTAG, "Waiting for previous data to be sent from outbox..."); 
-            };
-            vTaskDelay(10);
-            i++;
-          };
-          if (mqttIsConnected()) {
-            item->subscribed = _paramsMqttSubscribe(item);
-          } else {
-            rlog_d(logTAG, "Connection to MQTT broker was unexpectedly lost");
-            _failed = true;
-            break;
-          };
-        };
-        vTaskDelay(1);
+    params_pass_state_t _state = PARAMS_PASS_CONTINUE;
+    while (_state == PARAMS_PASS_CONTINUE) {
+      _state = _paramsMqttResubscribeStep(_pass);
+    };
+    #if CONFIG_PARAMS_MQTT_BULK
+      if (_state == PARAMS_PASS_COMPLETED) {
+        OPTIONS_LOCK();
+        _paramsMqttBulkSubscribe();
+        OPTIONS_UNLOCK();
+      };
+    #endif // CONFIG_PARAMS_MQTT_BULK
+    #if CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+      if (_state == PARAMS_PASS_COMPLETED) {
+        _paramsPublishResume();
       };
+    #endif // CONFIG_PARAMS_MQTT_PUBLISH_QUEUE
+    if (_state == PARAMS_PASS_STOPPED) {
+      // Collected but not sent topics will be collected again by the next pass
+      for (uint8_t i = 0; i < 3; i++) {
+        _paramsSubscribeBatches[i].count = 0;
+      };
+      rlog_d(logTAG, "Subscription to parameter topics interrupted, it will be resumed on the next connection");
     };
 
     #if CONFIG_SYSLED_MQTT_ACTIVITY
     ledSysOff(true);
     #endif // CONFIG_SYSLED_MQTT_ACTIVITY
-    OPTIONS_UNLOCK();
-
-    if (_failed) {
-      paramsMqttSubscribesClose();
-      mqttTaskRestart();
-    };
+    xSemaphoreGive(paramsSubscribeLock);
   };
 }
 
 void paramsMqttSubscribesClose()
 {
-  rlog_i(logTAG, "Resetting parameter topics...");
+  rlog_i(logTAG, "Closing parameter subscriptions...");
 
   OPTIONS_LOCK();
   #if CONFIG_SYSLED_MQTT_ACTIVITY
   ledSysOn(true);
   #endif // CONFIG_SYSLED_MQTT_ACTIVITY
 
+  // Stop the subscription pass, if it is running
+  _paramsResubscribePass++;
+
   // If there is a connection to the broker, you should complete it correctly
-  if (mqttIsConnected() && (paramsList)) {
+  bool _connected = mqttIsConnected();
+  if (_connected && (paramsList)) {
     paramsEntryHandle_t item;
     STAILQ_FOREACH(item, paramsList, next) {
+     ENTRY_LOCK(item);
      _paramsMqttUnubscribe(item);
+     ENTRY_UNLOCK(item);
      vTaskDelay(1);
     };
+    #if CONFIG_PARAMS_MQTT_BULK
+      paramsGroupHandle_t group;
+      STAILQ_FOREACH(group, paramsGroups, next) {
+        if ((group->topic_bulk) && (group->bulk_subscribed)) {
+          mqttUnsubscribe(group->topic_bulk);
+        };
+      };
+    #endif // CONFIG_PARAMS_MQTT_BULK
   };
 
-  // Free wildcard topic 
-  #if CONFIG_MQTT_PARAMS_WILDCARD
-    paramsMqttFreeWildcard();
-  #endif // CONFIG_MQTT_PARAMS_WILDCARD
+  // The broker keeps the subscriptions of a persistent session if the connection is lost
+  #if CONFIG_PARAMS_MQTT_PERSISTENT_SESSION
+  if (_connected) 
+  #endif // CONFIG_PARAMS_MQTT_PERSISTENT_SESSION
+  {
+    // Free wildcard topic 
+    #if CONFIG_MQTT_PARAMS_WILDCARD
+      paramsMqttFreeWildcard();
+    #endif // CONFIG_MQTT_PARAMS_WILDCARD
 
-  // Free all topics
-  if (paramsList) {
-    paramsEntryHandle_t item;
-    STAILQ_FOREACH(item, paramsList, next) {
-      paramsMqttTopicsFreeEntry(item);
-      item->subscribed = false;
-    };
+    // Topics are kept until the next connection, only subscriptions are reset
+    _paramsMqttResetSubscribed();
   };
 
   #if CONFIG_SYSLED_MQTT_ACTIVITY
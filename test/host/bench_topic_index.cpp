@@ -0,0 +1,88 @@
+// Host benchmark of the dispatch of incoming messages: the hashed topic index (_paramsMqttFindEntry) against
+// the linear strcasecmp() scan of the list of parameters that was used before it. The source is included to reach
+// the static functions of the manager
+#include "../../src/reParams.cpp"
+#include <stdio.h>
+#include <chrono>
+
+#define BENCH_MAX_PARAMS  300
+#define BENCH_GROUP_SIZE  10
+#define BENCH_LOOKUPS     1000000
+
+static const size_t _sizes[] = { 10, 100, 300 };
+
+static int32_t _values[BENCH_MAX_PARAMS];
+static char _keys[BENCH_MAX_PARAMS][16];
+static char _groups[BENCH_MAX_PARAMS / BENCH_GROUP_SIZE][16];
+// Copies of the topics, as the MQTT client passes them in its own buffers
+static char* _topics[BENCH_MAX_PARAMS + 1];
+static size_t _count = 0;
+
+static void registerParams(size_t count)
+{
+  paramsGroupHandle_t group = nullptr;
+  for (; _count < count; _count++) {
+    if ((_count % BENCH_GROUP_SIZE) == 0) {
+      char* name = _groups[_count / BENCH_GROUP_SIZE];
+      snprintf(name, sizeof(_groups[0]), "group%02u", (unsigned)(_count / BENCH_GROUP_SIZE));
+      group = paramsRegisterGroup(nullptr, name, name, name);
+    };
+    snprintf(_keys[_count], sizeof(_keys[0]), "param%03u", (unsigned)_count);
+    paramsEntryHandle_t entry = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_I32, nullptr, group,
+      _keys[_count], _keys[_count], CONFIG_MQTT_PARAMS_QOS, &_values[_count]);
+    free(_topics[_count]);
+    _topics[_count] = entry && entry->topic_subscribe ? strdup(entry->topic_subscribe) : nullptr;
+  };
+}
+
+// The scan of the list from paramsMqttIncomingMessage() before the index
+static paramsEntryHandle_t _linearFind(const char* topic)
+{
+  paramsEntryHandle_t item;
+  STAILQ_FOREACH(item, paramsList, next) {
+    if ((item->topic_subscribe) && (strcasecmp(item->topic_subscribe, topic) == 0)) {
+      return item;
+    };
+  };
+  return nullptr;
+}
+
+// Average time of one lookup in nanoseconds, topics are taken in turn, every (count+1)th topic is unknown
+template <typename F>
+static double measure(size_t count, F find, bool* valid)
+{
+  volatile size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+    size_t n = i % (count + 1);
+    paramsEntryHandle_t entry = find(_topics[n]);
+    if ((entry != nullptr) != (n < count)) *valid = false;
+    found = found + (entry != nullptr);
+  };
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  return (double)elapsed.count() / BENCH_LOOKUPS;
+}
+
+int main()
+{
+  bool valid = true;
+
+  hostMqtt.connected = true;
+  paramsInit();
+
+  printf("%10s %14s %14s %10s\n", "params", "index, ns", "linear, ns", "speedup");
+  for (size_t size : _sizes) {
+    registerParams(size);
+    free(_topics[size]);
+    _topics[size] = strdup("home/device/config/unknown/topic");
+
+    double indexed = measure(size, [](const char* topic) { return _paramsMqttFindEntry(topic); }, &valid);
+    double linear = measure(size, [](const char* topic) { return _linearFind(topic); }, &valid);
+    printf("%10u %14.1f %14.1f %9.1fx\n", (unsigned)size, indexed, linear, linear / indexed);
+  };
+
+  if (!valid) {
+    printf("lookup results do not match the registered topics\n");
+  };
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+#include "host_stubs.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <inttypes.h>
+
+// ---------------------------------------------------- rTypes / rLog ----------------------------------------------------
+
+char* malloc_string(const char* source)
+{
+  return source ? strdup(source) : nullptr;
+}
+
+char* malloc_stringf(const char* format, ...)
+{
+  char* ret = nullptr;
+  va_list args;
+  va_start(args, format);
+  if (vasprintf(&ret, format, args) < 0) ret = nullptr;
+  va_end(args);
+  return ret;
+}
+
+// ------------------------------------------------------ ESP-IDF -------------------------------------------------------
+
+const char* esp_err_to_name(esp_err_t code)
+{
+  return code == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
+
+void* esp_malloc(size_t size) { return malloc(size); }
+void* esp_calloc(size_t count, size_t size) { return calloc(count, size); }
+void espRestart(int reason) { abort(); }
+void ledSysOn(bool fixed) {}
+void ledSysOff(bool fixed) {}
+void ledSysActivity() {}
+
+// -------------------------------------------------------- NVS ---------------------------------------------------------
+
+// Storage is always empty, values are written nowhere
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+  *out_handle = 1;
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {}
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+
+#undef HOST_NVS_TYPE
+#define HOST_NVS_TYPE(s, t) \
+  esp_err_t nvs_set_##s(nvs_handle_t handle, const char* key, t value) { return ESP_OK; } \
+  esp_err_t nvs_get_##s(nvs_handle_t handle, const char* key, t* out_value) { return ESP_ERR_NVS_NOT_FOUND; }
+HOST_NVS_TYPE(i8, int8_t) HOST_NVS_TYPE(u8, uint8_t) HOST_NVS_TYPE(i16, int16_t) HOST_NVS_TYPE(u16, uint16_t)
+HOST_NVS_TYPE(i32, int32_t) HOST_NVS_TYPE(u32, uint32_t) HOST_NVS_TYPE(i64, int64_t) HOST_NVS_TYPE(u64, uint64_t)
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) { return ESP_OK; }
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) { return ESP_ERR_NVS_NOT_FOUND; }
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) { return ESP_OK; }
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) { return ESP_ERR_NVS_NOT_FOUND; }
+
+bool nvsInit() { return true; }
+bool nvsRead(const char* nameGroup, const char* nameParam, param_type_t typeParam, void* value) { return false; }
+bool nvsWrite(const char* nameGroup, const char* nameParam, param_type_t typeParam, void* value) { return true; }
+
+static size_t _valueSize(param_type_t type_value)
+{
+  switch (type_value) {
+    case OPT_TYPE_I8:     return sizeof(int8_t);
+    case OPT_TYPE_U8:     return sizeof(uint8_t);
+    case OPT_TYPE_I16:    return sizeof(int16_t);
+    case OPT_TYPE_U16:    return sizeof(uint16_t);
+    case OPT_TYPE_I32:    return sizeof(int32_t);
+    case OPT_TYPE_U32:    return sizeof(uint32_t);
+    case OPT_TYPE_I64:    return sizeof(int64_t);
+    case OPT_TYPE_U64:    return sizeof(uint64_t);
+    case OPT_TYPE_FLOAT:  return sizeof(float);
+    case OPT_TYPE_DOUBLE: return sizeof(double);
+    default:              return 0;
+  };
+}
+
+void* clone2value(param_type_t type_value, void* value)
+{
+  if (type_value == OPT_TYPE_STRING) return malloc_string((const char*)value);
+  size_t size = _valueSize(type_value);
+  void* ret = size ? malloc(size) : nullptr;
+  if (ret) memcpy(ret, value, size);
+  return ret;
+}
+
+bool equal2value(param_type_t type_value, void* value1, void* value2)
+{
+  if (type_value == OPT_TYPE_STRING) return strcmp((const char*)value1, (const char*)value2) == 0;
+  return memcmp(value1, value2, _valueSize(type_value)) == 0;
+}
+
+char* value2string(param_type_t type_value, void* value)
+{
+  switch (type_value) {
+    case OPT_TYPE_I8:     return malloc_stringf("%" PRIi8, *(int8_t*)value);
+    case OPT_TYPE_U8:     return malloc_stringf("%" PRIu8, *(uint8_t*)value);
+    case OPT_TYPE_I16:    return malloc_stringf("%" PRIi16, *(int16_t*)value);
+    case OPT_TYPE_U16:    return malloc_stringf("%" PRIu16, *(uint16_t*)value);
+    case OPT_TYPE_I32:    return malloc_stringf("%" PRIi32, *(int32_t*)value);
+    case OPT_TYPE_U32:    return malloc_stringf("%" PRIu32, *(uint32_t*)value);
+    case OPT_TYPE_I64:    return malloc_stringf("%" PRIi64, *(int64_t*)value);
+    case OPT_TYPE_U64:    return malloc_stringf("%" PRIu64, *(uint64_t*)value);
+    case OPT_TYPE_FLOAT:  return malloc_stringf("%f", *(float*)value);
+    case OPT_TYPE_DOUBLE: return malloc_stringf("%f", *(double*)value);
+    case OPT_TYPE_STRING: return malloc_string((const char*)value);
+    default:              return nullptr;
+  };
+}
+
+void* string2value(param_type_t type_value, char* value)
+{
+  void* ret = nullptr;
+  switch (type_value) {
+    case OPT_TYPE_STRING: return malloc_string(value);
+    case OPT_TYPE_FLOAT:  ret = malloc(sizeof(float)); *(float*)ret = strtof(value, nullptr); return ret;
+    case OPT_TYPE_DOUBLE: ret = malloc(sizeof(double)); *(double*)ret = strtod(value, nullptr); return ret;
+    default: {
+      size_t size = _valueSize(type_value);
+      if (size == 0) return nullptr;
+      int64_t num = strtoll(value, nullptr, 10);
+      ret = malloc(size);
+      memcpy(ret, &num, size);
+      return ret;
+    };
+  };
+}
+
+void setNewValue(param_type_t type_value, void* curr_value, void* new_value)
+{
+  size_t size = _valueSize(type_value);
+  if (size) memcpy(curr_value, new_value, size);
+}
+
+bool valueCheckLimits(param_type_t type_value, void* value, void* min_value, void* max_value)
+{
+  return true;
+}
+
+// ------------------------------------------------------- Events -------------------------------------------------------
+
+esp_event_base_t RE_PARAMS_EVENTS = "RE_PARAMS_EVENTS";
+esp_event_base_t RE_MQTT_EVENTS = "RE_MQTT_EVENTS";
+esp_event_base_t RE_SYSTEM_EVENTS = "RE_SYSTEM_EVENTS";
+
+bool eventLoopPost(esp_event_base_t event_base, int32_t event_id, void* event_data, size_t event_data_size, uint32_t ticks_to_wait)
+{
+  return true;
+}
+
+bool eventHandlerRegister(esp_event_base_t event_base, int32_t event_id, esp_event_handler_t event_handler, void* event_handler_arg)
+{
+  return true;
+}
+
+// -------------------------------------------------------- MQTT --------------------------------------------------------
+
+hostMqtt_t hostMqtt = { false, 0, 0, 0, 0, 0 };
+uint32_t hostMqttDropAfter = 0;
+
+void hostMqttSubscribePacket(size_t topics)
+{
+  hostMqtt.subscribe_packets++;
+  hostMqtt.subscribe_topics += topics;
+  hostMqtt.outbox_size += hostMqtt.outbox_per_subscribe;
+  if ((hostMqttDropAfter > 0) && (hostMqtt.subscribe_packets >= hostMqttDropAfter)) {
+    hostMqtt.connected = false;
+  };
+}
+
+bool mqttIsConnected()
+{
+  return hostMqtt.connected;
+}
+
+int mqttGetOutboxSize()
+{
+  return hostMqtt.outbox_size;
+}
+
+bool mqttSubscribe(const char* topic, int qos)
+{
+  if (!hostMqtt.connected) return false;
+  hostMqttSubscribePacket(1);
+  return true;
+}
+
+bool mqttUnsubscribe(const char* topic)
+{
+  return hostMqtt.connected;
+}
+
+bool mqttPublish(const char* topic, char* payload, int qos, bool retained, bool forced, bool free_payload)
+{
+  if (free_payload && payload) free(payload);
+  return hostMqtt.connected;
+}
+
+static char* _mqttTopicJoin(const char* topic1, const char* topic2, const char* topic3, const char* topic4)
+{
+  const char* parts[] = { topic1, topic2, topic3, topic4 };
+  size_t len = 0;
+  for (const char* part : parts) {
+    if (part) len += strlen(part) + 1;
+  };
+  char* ret = (char*)malloc(len + 1);
+  if (ret) {
+    ret[0] = '\0';
+    for (const char* part : parts) {
+      if (part) {
+        if (ret[0]) strcat(ret, "/");
+        strcat(ret, part);
+      };
+    };
+  };
+  return ret;
+}
+
+char* mqttGetSubTopic(const char* topic, const char* subtopic)
+{
+  return _mqttTopicJoin(topic, subtopic, nullptr, nullptr);
+}
+
+char* mqttGetTopicDevice(bool primary, bool local, const char* topic1, const char* topic2, const char* topic3)
+{
+  return _mqttTopicJoin("home/device", topic1, topic2, topic3);
+}
+
+char* mqttGetTopicLocation(bool primary, bool local, const char* topic1, const char* topic2, const char* topic3)
+{
+  return _mqttTopicJoin("home", topic1, topic2, topic3);
+}
+
+char* mqttGetTopicSpecial(bool primary, bool local, const char* topic1, const char* topic2, const char* topic3)
+{
+  return _mqttTopicJoin("special", topic1, topic2, topic3);
+}
+
+// ------------------------------------------------------ FreeRTOS ------------------------------------------------------
+
+TickType_t hostTicks = 0;
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return malloc(1); }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) { return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) { return pdTRUE; }
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore) { return nullptr; }
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { free(semaphore); }
+
+TickType_t xTaskGetTickCount()
+{
+  return hostTicks;
+}
+
+// Time passes only while the task sleeps, the outbox is drained at the same time
+void vTaskDelay(TickType_t ticks)
+{
+  hostTicks += ticks;
+  hostMqtt.outbox_size -= hostMqtt.outbox_drain * (int)ticks;
+  if (hostMqtt.outbox_size < 0) hostMqtt.outbox_size = 0;
+}
+
+void msTaskDelay(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+void vTaskSuspendAll() {}
+BaseType_t xTaskResumeAll() { return pdFALSE; }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t)&hostTicks; }
+
+// Background tasks and timers are not available on the host, the manager falls back to synchronous processing
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth, void* parameters,
+  UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id)
+{
+  return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t task) {}
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) { return pdFAIL; }
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks_to_wait) { return pdFALSE; }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) { return nullptr; }
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) { return pdFAIL; }
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait) { return pdFALSE; }
+void vQueueDelete(QueueHandle_t queue) {}
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t auto_reload, void* timer_id, TimerCallbackFunction_t callback)
+{
+  return nullptr;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks_to_wait) { return pdFAIL; }
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait) { return pdFAIL; }
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks_to_wait) { return pdFAIL; }
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) { return pdFALSE; }
@@ -0,0 +1,192 @@
+// Minimal stand-ins for ESP-IDF, FreeRTOS and the reXXX libraries used by reParams, enough to run the parameters
+// manager on the host. FreeRTOS is single-threaded here: mutexes are never contended, the tick counter is advanced
+// only by vTaskDelay(). The MQTT client is a fake broker connection controlled by the test through hostMqtt
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// ---------------------------------------------------- rTypes / rLog ----------------------------------------------------
+
+typedef enum {
+  OPT_KIND_PARAMETER = 0, OPT_KIND_PARAMETER_ONLINE, OPT_KIND_PARAMETER_LOCATION,
+  OPT_KIND_LOCDATA_ONLINE, OPT_KIND_LOCDATA_STORED, OPT_KIND_EXTDATA_ONLINE, OPT_KIND_EXTDATA_STORED,
+  OPT_KIND_COMMAND, OPT_KIND_OTA, OPT_KIND_SIGNAL, OPT_KIND_SIGNAL_AUTOCLR
+} param_kind_t;
+
+typedef enum {
+  OPT_TYPE_UNKNOWN = 0, OPT_TYPE_I8, OPT_TYPE_U8, OPT_TYPE_I16, OPT_TYPE_U16, OPT_TYPE_I32, OPT_TYPE_U32,
+  OPT_TYPE_I64, OPT_TYPE_U64, OPT_TYPE_FLOAT, OPT_TYPE_DOUBLE, OPT_TYPE_STRING
+} param_type_t;
+
+typedef int msg_priority_t;
+
+#define rlog_v(...)
+#define rlog_d(...)
+#define rlog_i(...)
+#define rlog_w(...)
+#define rlog_e(...)
+
+char* malloc_string(const char* source);
+char* malloc_stringf(const char* format, ...);
+
+// ------------------------------------------------------ ESP-IDF -------------------------------------------------------
+
+typedef int esp_err_t;
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_NVS_NOT_FOUND       0x1102
+#define ESP_ERR_NVS_INVALID_LENGTH  0x110c
+
+const char* esp_err_to_name(esp_err_t code);
+void* esp_malloc(size_t size);
+void* esp_calloc(size_t count, size_t size);
+void espRestart(int reason);
+enum { RR_COMMAND_RESET = 1 };
+
+void ledSysOn(bool fixed);
+void ledSysOff(bool fixed);
+void ledSysActivity();
+
+// -------------------------------------------------------- NVS ---------------------------------------------------------
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+#define HOST_NVS_TYPE(s, t) \
+  esp_err_t nvs_set_##s(nvs_handle_t handle, const char* key, t value); \
+  esp_err_t nvs_get_##s(nvs_handle_t handle, const char* key, t* out_value);
+HOST_NVS_TYPE(i8, int8_t) HOST_NVS_TYPE(u8, uint8_t) HOST_NVS_TYPE(i16, int16_t) HOST_NVS_TYPE(u16, uint16_t)
+HOST_NVS_TYPE(i32, int32_t) HOST_NVS_TYPE(u32, uint32_t) HOST_NVS_TYPE(i64, int64_t) HOST_NVS_TYPE(u64, uint64_t)
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length);
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value);
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length);
+
+bool nvsInit();
+bool nvsRead(const char* nameGroup, const char* nameParam, param_type_t typeParam, void* value);
+bool nvsWrite(const char* nameGroup, const char* nameParam, param_type_t typeParam, void* value);
+
+void* clone2value(param_type_t type_value, void* value);
+bool equal2value(param_type_t type_value, void* value1, void* value2);
+char* value2string(param_type_t type_value, void* value);
+void* string2value(param_type_t type_value, char* value);
+void setNewValue(param_type_t type_value, void* curr_value, void* new_value);
+bool valueCheckLimits(param_type_t type_value, void* value, void* min_value, void* max_value);
+
+// ------------------------------------------------------- Events -------------------------------------------------------
+
+typedef const char* esp_event_base_t;
+typedef void (*esp_event_handler_t)(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+#define ESP_EVENT_ANY_ID -1
+
+extern esp_event_base_t RE_PARAMS_EVENTS;
+extern esp_event_base_t RE_MQTT_EVENTS;
+extern esp_event_base_t RE_SYSTEM_EVENTS;
+enum { RE_PARAMS_CHANGED, RE_PARAMS_EQUALS, RE_PARAMS_INTERNAL, RE_PARAMS_RESTORED };
+enum { RE_MQTT_CONNECTED, RE_MQTT_CONN_LOST, RE_MQTT_CONN_FAILED, RE_MQTT_INCOMING_DATA };
+enum { RE_SYS_COMMAND };
+
+bool eventLoopPost(esp_event_base_t event_base, int32_t event_id, void* event_data, size_t event_data_size, uint32_t ticks_to_wait);
+bool eventHandlerRegister(esp_event_base_t event_base, int32_t event_id, esp_event_handler_t event_handler, void* event_handler_arg);
+
+// -------------------------------------------------------- MQTT --------------------------------------------------------
+
+typedef struct {
+  bool primary;
+} re_mqtt_event_data_t;
+
+typedef struct {
+  char* topic;
+  char* data;
+  size_t data_len;
+} re_mqtt_incoming_data_t;
+
+bool mqttIsConnected();
+int mqttGetOutboxSize();
+bool mqttSubscribe(const char* topic, int qos);
+bool mqttUnsubscribe(const char* topic);
+bool mqttPublish(const char* topic, char* payload, int qos, bool retained, bool forced, bool free_payload);
+char* mqttGetSubTopic(const char* topic, const char* subtopic);
+char* mqttGetTopicDevice(bool primary, bool local, const char* topic1, const char* topic2, const char* topic3);
+char* mqttGetTopicLocation(bool primary, bool local, const char* topic1, const char* topic2, const char* topic3);
+char* mqttGetTopicSpecial(bool primary, bool local, const char* topic1, const char* topic2, const char* topic3);
+
+// State of the fake broker connection
+typedef struct {
+  bool connected;
+  int outbox_size;              // current size of the outbox, bytes
+  int outbox_drain;             // bytes sent from the outbox per tick
+  int outbox_per_subscribe;     // bytes added to the outbox by each SUBSCRIBE packet
+  uint32_t subscribe_packets;   // SUBSCRIBE packets sent (single topics and batches)
+  uint32_t subscribe_topics;    // topics subscribed in total
+} hostMqtt_t;
+
+extern hostMqtt_t hostMqtt;
+
+// Disconnects the fake broker after the given number of SUBSCRIBE packets (0 - never)
+extern uint32_t hostMqttDropAfter;
+
+// Called by the fake client for each SUBSCRIBE packet
+void hostMqttSubscribePacket(size_t topics);
+
+// ------------------------------------------------------ FreeRTOS ------------------------------------------------------
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* TimerHandle_t;
+typedef void (*TaskFunction_t)(void*);
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+typedef enum { eNoAction = 0, eSetBits, eIncrement, eSetValueWithOverwrite, eSetValueWithoutOverwrite } eNotifyAction;
+
+#define pdFALSE               0
+#define pdTRUE                1
+#define pdFAIL                0
+#define pdPASS                1
+#define portMAX_DELAY         0xffffffffUL
+#define portTICK_PERIOD_MS    1
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define tskNO_AFFINITY        0x7fffffff
+
+// Simulated time, ticks
+extern TickType_t hostTicks;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void msTaskDelay(uint32_t ms);
+void vTaskSuspendAll();
+BaseType_t xTaskResumeAll();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth, void* parameters,
+  UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks_to_wait);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait);
+void vQueueDelete(QueueHandle_t queue);
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t auto_reload, void* timer_id, TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks_to_wait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks_to_wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
@@ -0,0 +1,37 @@
+// Project configuration for host tests: only the parameters manager and its MQTT subscriptions,
+// background tasks and timers are disabled
+#pragma once
+
+#define CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH      4
+#define CONFIG_PARAMS_INDEX_SIZE                64
+
+#define CONFIG_PARAMS_NVS_DELAYED_WRITE         0
+#define CONFIG_PARAMS_NVS_DEFERRED_RESTORE      0
+#define CONFIG_PARAMS_MQTT_PUBLISH_QUEUE        0
+#define CONFIG_PARAMS_MQTT_BULK                 0
+#define CONFIG_PARAMS_MQTT_BINARY               0
+#define CONFIG_PARAMS_HANDLER_ASYNC             0
+#define CONFIG_PARAMS_SUSPEND_SCHEDULER         0
+#define CONFIG_PARAMS_TELEGRAM_DIGEST           0
+#define CONFIG_TELEGRAM_ENABLE                  0
+#define CONFIG_NOTIFY_TELEGRAM_PARAM_CHANGED    0
+#define CONFIG_SYSLED_MQTT_ACTIVITY             0
+#define CONFIG_MQTT_OTA_ENABLE                  0
+#define CONFIG_MQTT_COMMAND_ENABLE              0
+
+#define CONFIG_MQTT_PARAMS_WILDCARD             0
+#define CONFIG_MQTT_PARAMS_CONFIRM_ENABLED      0
+#define CONFIG_MQTT_PARAMS_QOS                  1
+#define CONFIG_MQTT_PARAMS_RETAINED             1
+#define CONFIG_MQTT_CONFIRM_RETAINED            1
+
+#define CONFIG_MQTT_COMMON_FIENDLY              "Common"
+#define CONFIG_MQTT_COMMON_TOPIC                "common"
+#define CONFIG_MQTT_ROOT_PARAMS_LOCAL           0
+#define CONFIG_MQTT_ROOT_PARAMS_TOPIC           "config"
+#define CONFIG_MQTT_ROOT_CONFIRM_TOPIC          "confirm"
+#define CONFIG_MQTT_ROOT_LOCDATA_LOCAL          1
+#define CONFIG_MQTT_ROOT_LOCDATA_TOPIC          "local"
+#define CONFIG_MQTT_ROOT_SYSTEM_LOCAL           0
+#define CONFIG_MQTT_ROOT_SYSTEM_TOPIC           "system"
+#define CONFIG_MQTT_CMD_REBOOT                  "reboot"
@@ -0,0 +1,8 @@
+// The queue.h of glibc has no *_SAFE macros of the BSD version used by ESP-IDF
+#pragma once
+#include_next <sys/queue.h>
+
+#ifndef STAILQ_FOREACH_SAFE
+#define STAILQ_FOREACH_SAFE(var, head, field, tvar) \
+  for ((var) = STAILQ_FIRST((head)); (var) && ((tvar) = STAILQ_NEXT((var), field), 1); (var) = (tvar))
+#endif // STAILQ_FOREACH_SAFE
@@ -0,0 +1,221 @@
+// Host test of batched subscriptions on (re)connect: the MQTT client and FreeRTOS are replaced by stubs,
+// the batch hook counts SUBSCRIBE packets. The source is included to reach the static state of the manager
+#include "../../src/reParams.cpp"
+#include <stdio.h>
+
+static int _failed = 0;
+
+#define CHECK(expr) do { \
+  if (!(expr)) { \
+    printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); \
+    _failed++; \
+  }; \
+} while (0)
+
+// ---------------------------------------------------- Batch hook ------------------------------------------------------
+
+#define HOOK_MAX_CALLS 64
+
+typedef struct {
+  size_t calls;
+  size_t count[HOOK_MAX_CALLS];
+  int qos[HOOK_MAX_CALLS];
+  bool mixed_qos;
+} hookStats_t;
+
+static hookStats_t _hook;
+
+static bool hookSubscribeBatch(const char** topics, const int* qos, size_t count)
+{
+  if (!mqttIsConnected()) return false;
+  if (_hook.calls < HOOK_MAX_CALLS) {
+    _hook.count[_hook.calls] = count;
+    _hook.qos[_hook.calls] = qos[0];
+  };
+  for (size_t i = 1; i < count; i++) {
+    if (qos[i] != qos[0]) _hook.mixed_qos = true;
+  };
+  _hook.calls++;
+  hostMqttSubscribePacket(count);
+  return true;
+}
+
+// Number of hook calls with the given qos and number of topics
+static size_t hookCalls(int qos, size_t count)
+{
+  size_t ret = 0;
+  for (size_t i = 0; i < _hook.calls && i < HOOK_MAX_CALLS; i++) {
+    if ((_hook.qos[i] == qos) && (_hook.count[i] == count)) ret++;
+  };
+  return ret;
+}
+
+// ----------------------------------------------------- Fixture --------------------------------------------------------
+
+#define QOS0_COUNT 5
+#define QOS1_COUNT 10
+#define QOS2_COUNT 3
+#define PARAMS_COUNT (QOS0_COUNT + QOS1_COUNT + QOS2_COUNT)
+
+static int32_t _values[PARAMS_COUNT];
+static char _keys[PARAMS_COUNT][16];
+static paramsEntryHandle_t _entries[PARAMS_COUNT];
+
+// Parameters of different qos are interleaved, as they usually are in a real project
+static void registerParams()
+{
+  paramsGroupHandle_t group = paramsRegisterGroup(nullptr, "test", "test", "Test");
+  int left[3] = { QOS0_COUNT, QOS1_COUNT, QOS2_COUNT };
+  int qos = 0;
+  for (int i = 0; i < PARAMS_COUNT; i++) {
+    while (left[qos] == 0) qos = (qos + 1) % 3;
+    left[qos]--;
+    snprintf(_keys[i], sizeof(_keys[i]), "p%02d", i);
+    _entries[i] = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_I32, nullptr, group, _keys[i], _keys[i], qos, &_values[i]);
+    qos = (qos + 1) % 3;
+  };
+}
+
+static size_t subscribedCount()
+{
+  size_t ret = 0;
+  for (int i = 0; i < PARAMS_COUNT; i++) {
+    if (_entries[i] && _entries[i]->subscribed) ret++;
+  };
+  return ret;
+}
+
+// Connection lost and restored, returns the time from the connection to the end of the subscription pass
+static TickType_t reconnect()
+{
+  hostMqtt.connected = false;
+  paramsMqttSubscribesClose();
+  memset(&_hook, 0, sizeof(_hook));
+  hostMqtt.subscribe_packets = 0;
+  hostMqtt.subscribe_topics = 0;
+  hostMqtt.connected = true;
+  TickType_t start = xTaskGetTickCount();
+  paramsMqttSubscribesOpen(true, true);
+  return xTaskGetTickCount() - start;
+}
+
+// ------------------------------------------------------ Tests ---------------------------------------------------------
+
+static void test_batches_by_qos()
+{
+  printf("batches by qos\n");
+  paramsMqttSetSubscribeBatch(hookSubscribeBatch);
+  reconnect();
+
+  // ceil(count / CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH) packets for each qos
+  CHECK(_hook.calls == 2 + 3 + 1);
+  CHECK(!_hook.mixed_qos);
+  CHECK(hookCalls(0, 4) == 1);
+  CHECK(hookCalls(0, 1) == 1);
+  CHECK(hookCalls(1, 4) == 2);
+  CHECK(hookCalls(1, 2) == 1);
+  CHECK(hookCalls(2, 3) == 1);
+  CHECK(hostMqtt.subscribe_topics == PARAMS_COUNT);
+  CHECK(subscribedCount() == PARAMS_COUNT);
+}
+
+static void test_full_batch_sent_before_end_of_pass()
+{
+  printf("full batch is sent before the end of the pass\n");
+  paramsMqttSetSubscribeBatch(hookSubscribeBatch);
+  reconnect();
+
+  // Full batches go first, partial batches are flushed when the pass is completed
+  CHECK(_hook.calls == 6);
+  CHECK(_hook.count[0] == CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH);
+  CHECK(_hook.count[_hook.calls - 1] < CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH);
+}
+
+static void test_without_hook()
+{
+  printf("one SUBSCRIBE per topic without hook\n");
+  paramsMqttSetSubscribeBatch(nullptr);
+  reconnect();
+
+  CHECK(_hook.calls == 0);
+  CHECK(hostMqtt.subscribe_packets == PARAMS_COUNT);
+  CHECK(subscribedCount() == PARAMS_COUNT);
+}
+
+static void test_repeated_open()
+{
+  printf("repeated open does not subscribe again\n");
+  paramsMqttSetSubscribeBatch(hookSubscribeBatch);
+  reconnect();
+  memset(&_hook, 0, sizeof(_hook));
+  paramsMqttSubscribesOpen(true, true);
+
+  CHECK(_hook.calls == 0);
+  CHECK(subscribedCount() == PARAMS_COUNT);
+}
+
+static void test_connection_lost()
+{
+  printf("connection lost during the pass\n");
+  paramsMqttSetSubscribeBatch(hookSubscribeBatch);
+  hostMqttDropAfter = 2;
+  reconnect();
+  hostMqttDropAfter = 0;
+
+  // The pass stops at the first batch after the connection is lost, only the batch sent before is subscribed
+  CHECK(_hook.calls == 2);
+  CHECK(subscribedCount() == CONFIG_PARAMS_MQTT_SUBSCRIBE_BATCH);
+
+  reconnect();
+  CHECK(_hook.calls == 6);
+  CHECK(subscribedCount() == PARAMS_COUNT);
+}
+
+static void test_reconnect_to_ready()
+{
+  printf("reconnect-to-ready time with a slow outbox\n");
+  paramsFlowStats_t stats;
+
+  // Each SUBSCRIBE packet adds 300 bytes to the outbox, 20 bytes are sent per tick
+  hostMqtt.outbox_size = 0;
+  hostMqtt.outbox_per_subscribe = 300;
+  hostMqtt.outbox_drain = 20;
+
+  paramsMqttSetSubscribeBatch(nullptr);
+  TickType_t single = reconnect();
+  CHECK(subscribedCount() == PARAMS_COUNT);
+  paramsMqttFlowStats(&stats);
+  CHECK(stats.throttled > 0);
+  CHECK(stats.timeouts == 0);
+
+  hostMqtt.outbox_size = 0;
+  paramsMqttSetSubscribeBatch(hookSubscribeBatch);
+  TickType_t batched = reconnect();
+  CHECK(subscribedCount() == PARAMS_COUNT);
+  paramsMqttFlowStats(&stats);
+  CHECK(stats.timeouts == 0);
+
+  printf("  ready in %u ticks one by one, %u ticks in batches\n", (unsigned)single, (unsigned)batched);
+  CHECK(batched < single);
+
+  hostMqtt.outbox_size = 0;
+  hostMqtt.outbox_per_subscribe = 0;
+  hostMqtt.outbox_drain = 0;
+}
+
+int main()
+{
+  paramsInit();
+  registerParams();
+
+  test_batches_by_qos();
+  test_full_batch_sent_before_end_of_pass();
+  test_without_hook();
+  test_repeated_open();
+  test_connection_lost();
+  test_reconnect_to_ready();
+
+  paramsFree();
+  printf(_failed ? "%d check(s) failed\n" : "all tests passed\n", _failed);
+  return _failed ? 1 : 0;
+}